@@ -12,6 +12,7 @@
 #include <vector>
 #include <cassert>
 #include <algorithm>
+#include <limits>
 
 #include "amenities.h"
 #include "buildings.h"
@@ -29,14 +30,39 @@ using namespace tinyxml2;
   * @return s, the lowercase string
   */
 
-string toLowerAmenities(string s)
+string toLowerAmenities(string_view sv)
 {
+  string s(sv);
+
   for (char& c : s) c = tolower(c);
 
   return s;
 }
 
 
+/**
+  * @brief default constructor, creates an empty collection.
+  */
+Amenities::Amenities()
+  : Amenities(make_shared<StringPool>())
+{
+  // vectors are default initialized by their constructors
+}
+
+
+/**
+  * @brief creates an empty collection that keeps its text, and its
+  * indexes, in the given pool.
+  */
+Amenities::Amenities(shared_ptr<StringPool> strings)
+  : Strings(strings), NodeIndices(strings->getArena()), NumMissingNodes(0),
+    TypeIDs(strings->getArena()), LowerTypes(strings->getArena()), 
+    TypePostings(strings->getArena()), FastFoodTypeID(-1), WalkingGraph(nullptr),
+    Hierarchy(nullptr)
+{
+}
+
+
 /**
   * @brief constructor to retrieve all the amenities from the open street map.
   *
@@ -44,9 +70,11 @@ string toLowerAmenities(string s)
   * stores all the amenities into the vector data member.
   * 
   * @param xmldoc An XML document object denoting the open street map.
+  * @param nodes The nodes of the map, already loaded.
   * @return nothing.
   */
-Amenities::Amenities(XMLDocument& xmldoc)
+Amenities::Amenities(XMLDocument& xmldoc, Nodes& nodes)
+  : Amenities(make_shared<StringPool>())
 {
   XMLElement* osm = xmldoc.FirstChildElement("osm");
   assert(osm != nullptr);
@@ -56,100 +84,182 @@ Amenities::Amenities(XMLDocument& xmldoc)
   // looking for amenities:
   //
   XMLElement* element = osm->FirstChildElement();
-
-
+  OsmElement elem;
 
   while (element != nullptr)
   {
     string tag = element->Value();
     
-    if (tag != "node" && tag != "way") {
-      element = element->NextSiblingElement();
-      continue;
+    if (tag == "node" || tag == "way") {
+      osmReadElement(element, elem);
+      this->add(elem);
     }
+
+    element = element->NextSiblingElement();
+  }//while
+
+  this->finishLoading(nodes);
+}
+
+
+/**
+  * @brief stores the given element if it's a named amenity.
+  *
+  * @param elem A node or way from the open street map.
+  * @return nothing.
+  */
+void Amenities::add(const OsmElement& elem)
+{
+  if (elem.ElemKind == OsmElement::RELATION) {
+    return;
+  }
+
+  //
+  // if this is a amenity, store info into vector:
+  //
+  //
+  // the tags we need, found in one pass over the element's tags
+  // (the values are views into elem, nothing is copied yet):
+  //
+  static const string_view KEYS[] = { "amenity", "name", "addr:housenumber", "addr:street" };
+  string_view values[4];
+
+  osmGetKeyValues(elem, KEYS, values);
+
+  string_view amenityType = values[0];
     
-    const XMLAttribute* attr = element->FindAttribute("id");
-    assert(attr != nullptr);
-    
+  if (amenityType == "") { // not amenity, ignore!
+    return;
+  }
+
+  //
+  // each type is stored once; finishLoading( ) sorts the types and
+  // numbers them:
+  //
+  pmr::unordered_map<string_view, int>::iterator type = this->TypeIDs.find(amenityType);
+
+  if (type == this->TypeIDs.end()) {
+    type = this->TypeIDs.emplace(this->Strings->intern(amenityType), (int) this->amenityTypes.size()).first;
+
+    this->amenityTypes.push_back(type->first);
+  }
+
+  string_view amenityTypeView = type->first;
+
+  string streetAddr(values[2]);
+
+  streetAddr += " ";
+  streetAddr += values[3];
+
+  string_view name = values[1];
+  
+  if (name == "") { // no name, ignore!
+    return;
+  }
+
+  string_view nameView = this->Strings->intern(name);
+
+  string_view streetAddrView = this->Strings->intern(streetAddr);
+
+  //
+  // remember the associated node ids, which are resolved to
+  // indices in the node table by finishLoading( ):
+  //
+  size_t offset = this->PendingNodeIDs.size();
+
+  if (elem.ElemKind == OsmElement::NODE) {
     //
-    // if this is a amenity, store info into vector:
+    // this node defines the position of the amenity, so
+    // it's our only node reference:
     //
+    this->PendingNodeIDs.push_back(elem.ID);
+  }
+  else {
+    //
+    // the way has a list of nodes that define the perimeter,
+    // so collect the node ids as references to the perimeter
+    // nodes:
+    //
+    this->PendingNodeIDs.insert(this->PendingNodeIDs.end(), elem.Refs.begin(), elem.Refs.end());
+  }
 
-    string amenityType = osmGetKeyValue(element, "amenity");
-      
-    if (amenityType == "") { // not amenity, ignore!
-        element = element->NextSiblingElement();
-        continue;
-    }
+  this->PendingRanges.push_back(make_pair(offset, this->PendingNodeIDs.size() - offset));
+
+  //
+  // create amenity object, which refers to the strings stored
+  // above:
+  //
+  // The node/way id serves as the amenity id:
+  //
+  Amenity B(elem.ID, nameView, streetAddrView, amenityTypeView, {});
 
-    amenityTypes.push_back(amenityType);
+  //
+  // add the amenity to the vector:
+  //
+  this->osmAmenities.push_back(B);
+}
 
-    string streetAddr = osmGetKeyValue(element, "addr:housenumber")
-        + " "
-        + osmGetKeyValue(element, "addr:street");
 
-      //
-      // create amenity object, then add the associated
-      // node ids to the object:
-      //
-      // The node/way id serves as the amenity id:
-      //
-    long long id = attr->Int64Value();
+/**
+  * @brief called once all elements have been added, sorts the
+  * amenities by name and the amenity types alphabetically.
+  *
+  * @return nothing.
+  */
+void Amenities::finishLoading(Nodes& nodes)
+{
+  //
+  // resolve the node ids of every amenity to indices in the node
+  // table, all into one array:
+  //
+  this->NodeIndices.clear();
+  this->NodeIndices.reserve(this->PendingNodeIDs.size());
 
-    string name = osmGetKeyValue(element, "name");
-    
-    if (name == "") { // no name, ignore!
-        element = element->NextSiblingElement();
+  vector<pair<size_t, size_t>> resolved;
+
+  for (pair<size_t, size_t> range : this->PendingRanges)
+  {
+    size_t offset = this->NodeIndices.size();
+
+    for (size_t i = range.first; i < range.first + range.second; i++)
+    {
+      int index = nodes.findIndex(this->PendingNodeIDs[i]);
+
+      if (index < 0) {  // not in the map:
+        this->NumMissingNodes++;
         continue;
+      }
+
+      this->NodeIndices.push_back((uint32_t) index);
     }
 
-      Amenity B(id, name, streetAddr, amenityType);
-      
-      if (tag == "node") {
-        //
-        // this node defines the position of the amenity, so
-        // add to vector of node references as our only ref:
-        //
-        B.add(id);
-      }
-      else {
-        assert(tag == "way");
-        
-        //
-        // the way has a list of nodes that define the perimeter,
-        // so collect the node ids as references to the perimeter
-        // nodes:
-        //
-        XMLElement* nd = element->FirstChildElement("nd");
-        
-        while (nd != nullptr)
-        {
-          const XMLAttribute* ndref = nd->FindAttribute("ref");
-          assert(ndref != nullptr);
-
-          long long id = ndref->Int64Value();
-
-          B.add(id);
-
-          // advance to next node ref:
-          nd = nd->NextSiblingElement("nd");
-        }
-      }//else
+    resolved.push_back(make_pair(offset, this->NodeIndices.size() - offset));
+  }
+
+  //
+  // the array is complete, so it's safe to hand out views of it;
+  // the locations and bounding boxes are computed now, once:
+  //
+  NodeTable table = nodes.getTable();
+
+  for (size_t i = 0; i < resolved.size(); i++)
+  {
+    span<const uint32_t> indices(this->NodeIndices.data() + resolved[i].first, resolved[i].second);
+
+    this->osmAmenities[i].setNodeIndices(indices);
+    this->osmAmenities[i].setGeometry(table);
+  }
+
+  vector<long long>().swap(this->PendingNodeIDs);
+  vector<pair<size_t, size_t>>().swap(this->PendingRanges);
 
-      //
-      // add the amenity to the vector:
-      //
-      this->osmAmenities.push_back(B);
 
-    element = element->NextSiblingElement();
-  }//while
-  
   //
   // we have all the amenities, sort by name:
   //
 
   sort(osmAmenities.begin(), osmAmenities.end(), 
-  [](Amenity b1, Amenity b2) -> bool
+  [](const Amenity& b1, const Amenity& b2) -> bool
   {
     if (b1.getName() < b2.getName()) {
       return true;
@@ -161,7 +271,7 @@ Amenities::Amenities(XMLDocument& xmldoc)
   );
 
   sort(amenityTypes.begin(), amenityTypes.end(), 
-  [](string a1, string a2) -> bool
+  [](string_view a1, string_view a2) -> bool
   {
     if (a1 < a2) {
       return true;
@@ -172,8 +282,7 @@ Amenities::Amenities(XMLDocument& xmldoc)
   }
   );
 
-  vector<string>::iterator last_unique = unique(this->amenityTypes.begin(), this->amenityTypes.end());
-  this->amenityTypes.erase(last_unique, this->amenityTypes.end());
+  this->buildTypeIndexes();
 
  
   //
@@ -183,15 +292,215 @@ Amenities::Amenities(XMLDocument& xmldoc)
 }
 
 
+/**
+  * @brief saves the amenities and amenity types to a snapshot.
+  *
+  * @param out The snapshot being written.
+  * @return nothing.
+  */
+void Amenities::writeSnapshot(SnapshotWriter& out)
+{
+  for (Amenity& B : this->osmAmenities)
+  {
+    SnapshotAmenity record = {};
+
+    record.ID = B.getID();
+    record.Name = out.addString(B.getName());
+    record.StreetAddress = out.addString(B.getStreetAddress());
+    record.AmenityType = out.addString(B.getAmenityType());
+    record.NodeIndicesOffset = out.addNodeIndices(B.getNodeIndices());
+    record.NodeIndicesCount = B.getNodeIndices().size();
+
+    out.AmenityTable.push_back(record);
+  }
+
+  for (string_view type : this->amenityTypes) {
+    out.TypeTable.push_back(out.addString(type));
+  }
+}
+
+
+/**
+  * @brief switches to using the amenities and amenity types of a 
+  * (mapped) snapshot in place.
+  *
+  * The snapshot was taken after finishLoading( ), so the records
+  * are already in sorted order. The amenities refer directly to
+  * the snapshot's strings and node indices, nothing is copied;
+  * only the locations and bounding boxes are computed.
+  *
+  * @param snapshot The snapshot, which stays mapped while in use.
+  * @return nothing.
+  */
+void Amenities::readSnapshot(shared_ptr<Snapshot> snapshot)
+{
+  this->osmAmenities.clear();
+  this->amenityTypes.clear();
+  this->NodeIndices.clear();
+  this->PendingNodeIDs.clear();
+  this->PendingRanges.clear();
+  this->NumMissingNodes = 0;
+  this->TypeIDs.clear();
+
+  this->Mapped = snapshot;
+
+  NodeTable table = snapshot->getNodes();
+
+  for (const SnapshotAmenity& record : snapshot->getAmenities())
+  {
+    Amenity B(record.ID, 
+      snapshot->getString(record.Name),
+      snapshot->getString(record.StreetAddress),
+      snapshot->getString(record.AmenityType),
+      snapshot->getNodeIndices(record.NodeIndicesOffset, record.NodeIndicesCount));
+
+    B.setGeometry(table);
+
+    this->osmAmenities.push_back(B);
+  }
+
+  for (SnapshotString type : snapshot->getTypes()) {
+    this->amenityTypes.push_back(snapshot->getString(type));
+  }
+
+  this->buildTypeIndexes();
+}
+
+
+/**
+  * @brief # of node references that were not in the map.
+  *
+  * @return the # of node ids dropped by finishLoading.
+  */
+int Amenities::getNumMissingNodes() const
+{
+  return this->NumMissingNodes;
+}
+
+
+/**
+  * @brief the id of the given amenity type.
+  *
+  * @param amenityType The type of amenity.
+  * @return the position in amenityTypes, or -1 if there's no such type.
+  */
+int Amenities::getTypeID(string_view amenityType) const
+{
+  pmr::unordered_map<string_view, int>::const_iterator it = this->TypeIDs.find(amenityType);
+
+  if (it == this->TypeIDs.end()) {
+    return -1;
+  }
+
+  return it->second;
+}
+
+
+/**
+  * @brief the amenities of the given type.
+  *
+  * @param typeID The id of the type.
+  * @return the positions in osmAmenities, in order.
+  */
+span<const int> Amenities::getAmenitiesOfType(int typeID) const
+{
+  if (typeID < 0 || typeID >= (int) this->TypePostings.size()) {
+    return {};
+  }
+
+  return this->TypePostings[typeID];
+}
+
+
+/**
+  * @brief the spatial index over the amenities of the given type.
+  *
+  * @param amenityType The type of amenity, or its id.
+  * @return the index, or nullptr if there are no such amenities.
+  */
+const SpatialIndex* Amenities::getSpatialIndex(string_view amenityType) const
+{
+  return this->getSpatialIndex(this->getTypeID(amenityType));
+}
+
+const SpatialIndex* Amenities::getSpatialIndex(int typeID) const
+{
+  if (this->getAmenitiesOfType(typeID).empty()) {
+    return nullptr;
+  }
+
+  return &this->SpatialIndexes[typeID];
+}
+
+
+//
+// numbers the (sorted) types, and indexes the amenities by type; 
+// the items are positions in osmAmenities, so this is called 
+// after sorting:
+//
+void Amenities::buildTypeIndexes()
+{
+  size_t numTypes = this->amenityTypes.size();
+
+  this->TypeIDs.clear();
+  this->LowerTypes.clear();
+
+  for (size_t t = 0; t < numTypes; t++) {
+    this->TypeIDs[this->amenityTypes[t]] = (int) t;
+    this->LowerTypes.push_back(this->Strings->intern(toLowerAmenities(this->amenityTypes[t])));
+  }
+
+  this->TypePostings.clear();
+  this->TypePostings.resize(numTypes);  // each in the arena, too
+  this->SpatialIndexes.clear();
+  this->SpatialIndexes.resize(numTypes);
+
+  for (size_t i = 0; i < this->osmAmenities.size(); i++)
+  {
+    int typeID = this->getTypeID(this->osmAmenities[i].getAmenityType());
+
+    this->osmAmenities[i].setTypeID(typeID);
+
+    if (typeID < 0) {
+      continue;
+    }
+
+    pair<double, double> location = this->osmAmenities[i].getLocation();
+
+    this->TypePostings[typeID].push_back((int) i);
+    this->SpatialIndexes[typeID].add((int) i, location.first, location.second);
+  }
+
+  for (SpatialIndex& index : this->SpatialIndexes) {
+    index.build();
+  }
+
+  this->FastFoodTypeID = this->getTypeID("fast_food");
+
+  //
+  // the amenities have moved, so they must be joined to the
+  // walking graph again:
+  //
+  this->WalkingGraph = nullptr;
+  this->GraphVertices.clear();
+  this->GraphDistances.clear();
+  this->TypeVertices.clear();
+  this->Hierarchy = nullptr;
+  this->TypeTargets.clear();
+  this->TypeTargetsReady = nullptr;
+}
+
+
 /**
   * @brief prints all the amenities in summary form.
   *
+  * @param out Where to print, the console by default.
   * @return nothing
   */
-void Amenities::print()
+void Amenities::print(ostream& out) const
 {
-  for (Amenity B : this->osmAmenities) {
-    B.print();
+  for (const Amenity& B : this->osmAmenities) {
+    B.print(out);
   }
   return;
 }
@@ -201,18 +510,23 @@ void Amenities::findAndPrint(Amenities& amenities, Nodes& nodes, int num_of_amen
     string amenity;
     getline(cin, amenity);  // read rest of line in case multiple words in building amenity
 
+    amenities.findAndPrint(amenity, nodes, cout);
+}
+
+void Amenities::findAndPrint(string amenity, const Nodes& nodes, ostream& out) const
+{
     while (isspace(amenity[0])){
       amenity.erase(0, 1);
     } 
     
     if (amenity == "") {
-      for (size_t i = 0; i < (amenities.amenityTypes.size() / 5); i++){
-        cout << amenities.amenityTypes[i * 5] << " " << amenities.amenityTypes[i * 5 + 1] << " " << amenities.amenityTypes[i * 5 + 2] << " " << amenities.amenityTypes[i * 5 + 3] << " " << amenities.amenityTypes[i * 5 + 4] << endl;
+      for (size_t i = 0; i < (this->amenityTypes.size() / 5); i++){
+        out << this->amenityTypes[i * 5] << " " << this->amenityTypes[i * 5 + 1] << " " << this->amenityTypes[i * 5 + 2] << " " << this->amenityTypes[i * 5 + 3] << " " << this->amenityTypes[i * 5 + 4] << '\n';
       }
-      for (size_t i = (amenities.amenityTypes.size() - (amenities.amenityTypes.size() % 5)); i < amenities.amenityTypes.size(); i++){
-        cout << amenities.amenityTypes[i] << " ";
+      for (size_t i = (this->amenityTypes.size() - (this->amenityTypes.size() % 5)); i < this->amenityTypes.size(); i++){
+        out << this->amenityTypes[i] << " ";
       }
-      cout << endl;
+      out << '\n';
     }      
 
 
@@ -221,58 +535,689 @@ void Amenities::findAndPrint(Amenities& amenities, Nodes& nodes, int num_of_amen
       // find every amenity that contains this name, use 
       // a case-insensitive search and print a detailed output:
       //
-      
-      string check_amenity = toLowerAmenities(amenity);
-      bool check = false;
+      vector<int> matches = this->findByType(amenity);
 
-      for (int i = 0; i < num_of_amenities; i++){
-        string lowercase_amenity = toLowerAmenities(amenities.osmAmenities[i].getAmenityType());
-
-        if (lowercase_amenity.find(check_amenity) != string::npos){
-          amenities.osmAmenities[i].print(nodes);
-          check = true;
-        }
+      for (int i : matches){
+        this->osmAmenities[i].print(nodes, out);
       }
-      if (check == false){
-        cout << "No such amenity" << endl;
+      if (matches.empty()){
+        out << "No such amenity" << '\n';
       }
     }   
 
 }
 
-void Amenities::findNearestFastFood(Amenities& amenities, Buildings& buildings, Nodes& nodes, int num_of_amenities, vector< pair < int, pair <double, double> > > coordinates_list)
+/**
+  * @brief the amenities whose type contains the given text,
+  * ignoring case.
+  *
+  * @param amenity The text to search for; leading spaces are ignored.
+  * @return the positions in osmAmenities, in order
+  */
+vector<int> Amenities::findByType(string amenity) const
 {
-    for (pair < int, pair <double, double> > coordinates: coordinates_list){
+  vector<int> matches;
+
+  while (isspace(amenity[0])){
+    amenity.erase(0, 1);
+  } 
+
+  string check_amenity = toLowerAmenities(amenity);
+
+  //
+  // the types are matched in the dictionary, then their amenities
+  // are merged back into order:
+  //
+  size_t numTypes = 0;
+
+  for (size_t t = 0; t < this->LowerTypes.size(); t++){
+    if (this->LowerTypes[t].find(check_amenity) != string::npos){
+      matches.insert(matches.end(), this->TypePostings[t].begin(), this->TypePostings[t].end());
+      numTypes++;
+    }
+  }
+
+  if (numTypes > 1){
+    sort(matches.begin(), matches.end());
+  }
+
+  return matches;
+}
+
+void Amenities::findNearestFastFood(const Amenities& amenities, const Buildings& buildings, const Nodes& nodes, int num_of_amenities, vector< pair < int, pair <double, double> > > coordinates_list, ostream& out) const
+{
+  for (pair < int, pair <double, double> > coordinates: coordinates_list){
     
     float distance = -1;
     string name = "";
     string address = "";
 
-    // If there is a building match, loop through all the amenities to check if an amenity is fast food, and find the closest fast food option.
-
-    for (int i = 0; i < num_of_amenities; i++){
-      if (amenities.osmAmenities[i].getAmenityType() == "fast_food"){
-        pair <double, double> new_coordinates = amenities.osmAmenities[i].getLocation(nodes);
-        float new_distance = distBetween2Points(coordinates.second.first, coordinates.second.second, new_coordinates.first, new_coordinates.second);
-        
-        if (distance < 0){
-          distance = new_distance;
-          name = amenities.osmAmenities[i].getName();
-          address = amenities.osmAmenities[i].getStreetAddress();
+    // If there is a building match, find the closest fast food option.
+
+    int i = amenities.findNearestFastFood(coordinates.second.first, coordinates.second.second, distance);
+
+    if (i >= 0){
+      name = amenities.osmAmenities[i].getName();
+      address = amenities.osmAmenities[i].getStreetAddress();
+    }
+
+    out << buildings.osmBuildings[coordinates.first].getName() << '\n';
+    out << name << " (fast_food): " << address << '\n';
+    out << " Distance: " << distance << " miles" << '\n';
+  }
+
+  if (coordinates_list.size() < 1){
+    out << "No such building" << '\n';
+  }
+}
+
+
+/**
+  * @brief the fast food amenity nearest to the given location.
+  *
+  * Distances are compared as floats, and among fast food at the
+  * same distance the first one (by name) wins. The spatial index
+  * finds the nearest one; every amenity within a hair of that 
+  * distance is then checked in order, the same way a scan of all
+  * the amenities would.
+  *
+  * @param lat Latitude of the location.
+  * @param lon Longitude of the location.
+  * @param distance Output: the distance in miles, -1 if none.
+  * @return the position in osmAmenities, -1 if there's no fast food
+  */
+int Amenities::findNearestFastFood(double lat, double lon, float& distance) const
+{
+  int nearestAmenity = -1;
+
+  distance = -1;
+
+  const SpatialIndex* index = this->getSpatialIndex(this->FastFoodTypeID);
+  vector<SpatialIndex::Neighbor> candidates;
+
+  if (index != nullptr) {
+    vector<SpatialIndex::Neighbor> nearest = index->nearest(lat, lon, 1);
+
+    if (!nearest.empty()) {
+      candidates = index->withinRadius(lat, lon, nearest[0].Distance * (1 + 1e-6));
+    }
+
+    sort(candidates.begin(), candidates.end(),
+      [](const SpatialIndex::Neighbor& n1, const SpatialIndex::Neighbor& n2) -> bool
+      {
+        return n1.Item < n2.Item;
+      }
+    );
+  }
+
+  for (const SpatialIndex::Neighbor& candidate : candidates){
+    float new_distance = candidate.Distance;
+
+    if (distance < 0 || new_distance < distance){
+      distance = new_distance;
+      nearestAmenity = candidate.Item;
+    }
+  }
+
+  return nearestAmenity;
+}
+
+
+/**
+  * @brief sets the walking graph used by the walking queries, and
+  * finds where each amenity joins it.
+  *
+  * @param graph The walking graph of the map.
+  * @return nothing.
+  */
+void Amenities::setGraph(const Graph& graph)
+{
+  this->WalkingGraph = &graph;
+
+  this->GraphVertices.assign(this->osmAmenities.size(), -1);
+  this->GraphDistances.assign(this->osmAmenities.size(), 0);
+  this->TypeVertices.clear();
+  this->TypeVertices.resize(this->amenityTypes.size());
+
+  for (size_t i = 0; i < this->osmAmenities.size(); i++)
+  {
+    const Amenity& A = this->osmAmenities[i];
+    pair<double, double> location = A.getLocation();
+    double distance;
+
+    int vertex = graph.nearestVertex(location.first, location.second, distance);
+
+    if (vertex < 0 || A.getTypeID() < 0) {  // no graph, or nowhere to be:
+      continue;
+    }
+
+    this->GraphVertices[i] = vertex;
+    this->GraphDistances[i] = (float) distance;
+    this->TypeVertices[A.getTypeID()].push_back(make_pair((uint32_t) vertex, (int) i));
+  }
+
+  for (vector<pair<uint32_t, int>>& vertices : this->TypeVertices) {
+    sort(vertices.begin(), vertices.end());
+  }
+
+  this->Hierarchy = nullptr;
+  this->TypeTargets.clear();
+  this->TypeTargetsReady = nullptr;
+}
+
+
+/**
+  * @brief sets the contraction hierarchy of the walking graph.
+  *
+  * @param hierarchy The hierarchy over the graph given to setGraph( ).
+  * @return nothing.
+  */
+void Amenities::setHierarchy(const ContractionHierarchy& hierarchy)
+{
+  this->Hierarchy = &hierarchy;
+
+  this->TypeTargets.clear();
+  this->TypeTargets.resize(this->TypeVertices.size());
+  this->TypeTargetsReady = make_unique<once_flag[]>(this->TypeVertices.size());
+}
+
+
+//
+// the amenities of the given type, prepared as targets in the
+// hierarchy; queries run in parallel, so the first one to need
+// them prepares them while any others wait:
+//
+const HierarchyTargets& Amenities::getTypeTargets(int typeID) const
+{
+  call_once(this->TypeTargetsReady[typeID], [&]()
+  {
+    vector<pair<uint32_t, double>> targets;
+
+    for (pair<uint32_t, int> vertex : this->TypeVertices[typeID]) {
+      targets.push_back(make_pair(vertex.first, (double) this->GraphDistances[vertex.second]));
+    }
+
+    this->Hierarchy->prepareTargets(targets, this->TypeTargets[typeID], GraphSearch::forThisThread());
+  });
+
+  return this->TypeTargets[typeID];
+}
+
+
+/**
+  * @brief the fast food amenity nearest to a building by walking
+  * distance, starting from its entrances.
+  *
+  * @param buildings The buildings of the map.
+  * @param nodes The nodes of the map, for the building entrances.
+  * @param building The position of the building in osmBuildings.
+  * @param distance Output: the walking distance in miles, -1 if none.
+  * @return the position in osmAmenities, -1 if there's no fast food
+  */
+int Amenities::findNearestFastFoodWalking(const Buildings& buildings, const Nodes& nodes, int building, float& distance) const
+{
+  distance = -1;
+
+  if (this->WalkingGraph == nullptr) {
+    return -1;
+  }
+
+  int typeIDs[1] = { this->FastFoodTypeID };
+
+  vector<pair<int, float>> nearest = this->findNearestWalking(
+    buildings.getWalkingSources(building, nodes, *this->WalkingGraph), typeIDs, 1);
+
+  if (nearest.empty()) {
+    return -1;
+  }
+
+  distance = nearest[0].second;
+
+  return nearest[0].first;
+}
+
+
+/**
+  * @brief the walking distance from the sources to an amenity, by
+  * A* search.
+  *
+  * For one target, A* settles about a quarter of the vertices
+  * Dijkstra does on the campus map, and is a little quicker than
+  * bidirectional A* (see bench/route_bench.cpp).
+  *
+  * @param sources Where the walk starts.
+  * @param amenity The position of the amenity in osmAmenities.
+  * @return the walking distance in miles, -1 if none
+  */
+float Amenities::findWalkingDistance(span<const pair<uint32_t, double>> sources, int amenity) const
+{
+  if (this->WalkingGraph == nullptr || amenity < 0 || amenity >= (int) this->GraphVertices.size() ||
+    this->GraphVertices[amenity] < 0)
+  {
+    return -1;
+  }
+
+  uint32_t target = (uint32_t) this->GraphVertices[amenity];
+  double walked = numeric_limits<double>::infinity();
+
+  if (this->Hierarchy != nullptr)
+  {
+    pair<uint32_t, double> targets[1] = { make_pair(target, (double) this->GraphDistances[amenity]) };
+
+    walked = this->Hierarchy->findDistance(sources, targets, GraphSearch::forThisThread(0), GraphSearch::forThisThread(1));
+  }
+  else
+  {
+    GraphSearch& search = GraphSearch::forThisThread();
+    uint32_t vertex;
+    double distance;
+
+    search.start(*this->WalkingGraph);
+    search.setTarget(target);
+
+    for (pair<uint32_t, double> source : sources) {
+      search.addSource(source.first, source.second);
+    }
+
+    while (search.next(vertex, distance))
+    {
+      if (vertex == target) {
+        walked = distance + this->GraphDistances[amenity];
+        break;
+      }
+    }
+  }
+
+  if (walked == numeric_limits<double>::infinity()) {
+    return -1;
+  }
+
+  return (float) walked;
+}
+
+
+/**
+  * @brief the k amenities of the given types nearest to the sources
+  * by walking distance.
+  *
+  * Vertices are settled in order of distance, and an amenity is
+  * never nearer than the vertex where it joins the graph, so once
+  * k amenities have been found and the search is farther than the
+  * k-th of them, the rest can only be farther still. With a
+  * hierarchy, one upward search per type does the same, each
+  * bounded by the k-th nearest found by the types before it.
+  *
+  * @param sources Where the walk starts.
+  * @param typeIDs The types of amenity wanted.
+  * @param k The # of amenities wanted.
+  * @return up to k (position in osmAmenities, walking distance),
+  *   nearest first
+  */
+vector<pair<int, float>> Amenities::findNearestWalking(span<const pair<uint32_t, double>> sources, span<const int> typeIDs, size_t k) const
+{
+  vector<pair<int, float>> nearest;
+
+  if (this->WalkingGraph == nullptr || k == 0) {
+    return nearest;
+  }
+
+  //
+  // the types wanted that have amenities on the graph, each once:
+  //
+  vector<int> wanted;
+
+  for (int typeID : typeIDs)
+  {
+    if (typeID < 0 || typeID >= (int) this->TypeVertices.size() || this->TypeVertices[typeID].empty()) {
+      continue;
+    }
+
+    if (find(wanted.begin(), wanted.end(), typeID) == wanted.end()) {
+      wanted.push_back(typeID);
+    }
+  }
+
+  if (wanted.empty()) {
+    return nearest;
+  }
+
+  //
+  // the best k found so far, nearest first:
+  //
+  vector<pair<double, int>> best;
+
+  auto consider = [&](double distance, int position)
+  {
+    pair<double, int> found = make_pair(distance, position);
+
+    if (best.size() == k && found >= best.back()) {
+      return;
+    }
+
+    best.insert(upper_bound(best.begin(), best.end(), found), found);
+
+    if (best.size() > k) {
+      best.pop_back();
+    }
+  };
+
+  GraphSearch& search = GraphSearch::forThisThread();
+
+  if (this->Hierarchy != nullptr)
+  {
+    //
+    // one upward search per type finds the distances to all the
+    // amenities of the type, bounded by the k-th best so far:
+    //
+    vector<double> distances;
+
+    for (int typeID : wanted)
+    {
+      const vector<pair<uint32_t, int>>& targets = this->TypeVertices[typeID];
+      double bound = (best.size() == k) ? best.back().first : numeric_limits<double>::infinity();
+
+      this->Hierarchy->findDistances(sources, this->getTypeTargets(typeID), distances, search, bound);
+
+      for (size_t t = 0; t < targets.size(); t++)
+      {
+        if (distances[t] != numeric_limits<double>::infinity()) {  // can walk there:
+          consider(distances[t], targets[t].second);
         }
-        else if (new_distance < distance){
-          distance = new_distance;
-          name = amenities.osmAmenities[i].getName();
-          address = amenities.osmAmenities[i].getStreetAddress();
+      }
+    }
+  }
+  else
+  {
+    search.start(*this->WalkingGraph);
+
+    for (pair<uint32_t, double> source : sources) {
+      search.addSource(source.first, source.second);
+    }
+
+    uint32_t vertex;
+    double walked;
+
+    while (search.next(vertex, walked))
+    {
+      if (best.size() == k && walked > best.back().first) {
+        break;
+      }
+
+      for (int typeID : wanted)
+      {
+        const vector<pair<uint32_t, int>>& targets = this->TypeVertices[typeID];
+        vector<pair<uint32_t, int>>::const_iterator it = lower_bound(targets.begin(), targets.end(), make_pair(vertex, -1));
+
+        for (; it != targets.end() && it->first == vertex; it++) {
+          consider(walked + this->GraphDistances[it->second], it->second);
         }
       }
     }
-    cout << buildings.osmBuildings[coordinates.first].getName() << endl;
-    cout << name << " (fast_food): " << address << endl;
-    cout << " Distance: " << distance << " miles" << endl;
+  }
+
+  for (pair<double, int> found : best) {
+    nearest.push_back(make_pair(found.second, (float) found.first));
+  }
+
+  return nearest;
+}
+
+
+//
+// local helper: the convex hull of the given (lat, lon) points, in
+// counterclockwise order, by Andrew's monotone chain (longitude as
+// x, latitude as y):
+//
+static vector<pair<double, double>> convexHull(vector<pair<double, double>> points)
+{
+  auto byLon = [](const pair<double, double>& a, const pair<double, double>& b)
+  {
+    return make_pair(a.second, a.first) < make_pair(b.second, b.first);
+  };
+
+  auto cross = [](const pair<double, double>& o, const pair<double, double>& a, const pair<double, double>& b)
+  {
+    return (a.second - o.second) * (b.first - o.first) - (a.first - o.first) * (b.second - o.second);
+  };
+
+  sort(points.begin(), points.end(), byLon);
+  points.erase(unique(points.begin(), points.end()), points.end());
+
+  if (points.size() < 3) {
+    return points;
+  }
+
+  vector<pair<double, double>> hull(2 * points.size());
+  size_t n = 0;
+
+  for (size_t i = 0; i < points.size(); i++)  // lower half
+  {
+    while (n >= 2 && cross(hull[n - 2], hull[n - 1], points[i]) <= 0) {
+      n--;
+    }
+
+    hull[n++] = points[i];
+  }
+
+  for (size_t i = points.size() - 1, lower = n + 1; i > 0; i--)  // upper half
+  {
+    while (n >= lower && cross(hull[n - 2], hull[n - 1], points[i - 1]) <= 0) {
+      n--;
+    }
+
+    hull[n++] = points[i - 1];
+  }
+
+  hull.resize(n - 1);  // the first point is also last
+
+  return hull;
+}
+
+
+/**
+  * @brief the amenities within each of the given walking times of
+  * the sources.
+  *
+  * The search runs out to the longest time; everything it settles
+  * by then has its final distance, and anything it hasn't is out of
+  * reach. The outline of the area within a time is the hull of the
+  * vertices within it and of the points part way along the edges
+  * leaving them where the time runs out.
+  *
+  * @param sources Where the walk starts.
+  * @param minutes The walking times.
+  * @param withPolygons Whether to outline the area within each time.
+  * @return what's within each time, in the order given
+  */
+vector<WalkingIsochrone> Amenities::findWithinWalking(span<const pair<uint32_t, double>> sources, span<const double> minutes, bool withPolygons) const
+{
+  vector<WalkingIsochrone> isochrones(minutes.size());
+  vector<double> limits(minutes.size());  // in miles
+  double farthest = -1;
+
+  for (size_t i = 0; i < minutes.size(); i++)
+  {
+    isochrones[i].Minutes = minutes[i];
+    limits[i] = minutes[i] / 60.0 * WALKING_SPEED;
+    farthest = max(farthest, limits[i]);
+  }
+
+  if (this->WalkingGraph == nullptr || farthest < 0) {
+    return isochrones;
+  }
+
+  const Graph& graph = *this->WalkingGraph;
+  GraphSearch& search = GraphSearch::forThisThread();
+
+  search.start(graph);
+
+  for (pair<uint32_t, double> source : sources) {
+    search.addSource(source.first, source.second);
+  }
+
+  //
+  // the vertices within the longest time, in order of distance (kept
+  // only for the outlines):
+  //
+  vector<pair<uint32_t, double>> settled;
+  uint32_t vertex;
+  double walked;
+
+  while (search.next(vertex, walked))
+  {
+    if (walked > farthest) {
+      break;
+    }
+
+    if (withPolygons) {
+      settled.push_back(make_pair(vertex, walked));
+    }
+  }
+
+  //
+  // the amenities of each type within reach, nearest first, and
+  // then within each time:
+  //
+  for (size_t typeID = 0; typeID < this->TypeVertices.size(); typeID++)
+  {
+    vector<pair<double, int>> found;
+
+    for (pair<uint32_t, int> target : this->TypeVertices[typeID])
+    {
+      double distance = search.getDistance(target.first) + this->GraphDistances[target.second];
+
+      if (distance <= farthest) {
+        found.push_back(make_pair(distance, target.second));
+      }
+    }
+
+    if (found.empty()) {
+      continue;
+    }
+
+    sort(found.begin(), found.end());
+
+    for (size_t i = 0; i < isochrones.size(); i++)
+    {
+      vector<pair<int, float>> within;
+
+      for (size_t j = 0; j < found.size() && found[j].first <= limits[i]; j++) {
+        within.push_back(make_pair(found[j].second, (float) found[j].first));
+      }
+
+      if (!within.empty()) {
+        isochrones[i].ByType.push_back(make_pair((int) typeID, move(within)));
+      }
+    }
+  }
+
+  if (!withPolygons) {
+    return isochrones;
+  }
+
+  for (size_t i = 0; i < isochrones.size(); i++)
+  {
+    vector<pair<double, double>> points;
+
+    for (size_t j = 0; j < settled.size() && settled[j].second <= limits[i]; j++)
+    {
+      uint32_t from = settled[j].first;
+      double left = limits[i] - settled[j].second;  // miles left to walk
+      span<const uint32_t> targets = graph.getTargets(from);
+      span<const float> weights = graph.getWeights(from);
+
+      points.push_back(make_pair(graph.getLat(from), graph.getLon(from)));
+
+      for (size_t e = 0; e < targets.size(); e++)
+      {
+        if (weights[e] <= left) {  // the far end is within reach itself
+          continue;
+        }
+
+        double t = left / weights[e];
+
+        points.push_back(make_pair(
+          graph.getLat(from) + t * (graph.getLat(targets[e]) - graph.getLat(from)),
+          graph.getLon(from) + t * (graph.getLon(targets[e]) - graph.getLon(from))));
+      }
+    }
+
+    isochrones[i].Polygon = convexHull(move(points));
+  }
+
+  return isochrones;
+}
+
+
+void Amenities::findWithinWalking(const Buildings& buildings, const Nodes& nodes, const vector< pair < int, pair <double, double> > >& coordinates_list, ostream& out) const
+{
+  static const double MINUTES[] = { 5, 10, 15 };
+
+  for (const pair < int, pair <double, double> >& coordinates: coordinates_list){
+
+    vector<pair<uint32_t, double>> sources;
+
+    if (this->WalkingGraph != nullptr){
+      sources = buildings.getWalkingSources(coordinates.first, nodes, *this->WalkingGraph);
+    }
+
+    out << buildings.osmBuildings[coordinates.first].getName() << '\n';
+
+    for (const WalkingIsochrone& isochrone : this->findWithinWalking(sources, MINUTES)){
+
+      size_t count = 0;
+
+      for (const pair<int, vector<pair<int, float>>>& type : isochrone.ByType){
+        count += type.second.size();
+      }
+
+      out << " Within " << isochrone.Minutes << " minutes: " << count << " amenities" << '\n';
+
+      // each type, with the names of its named amenities, nearest first:
+      for (const pair<int, vector<pair<int, float>>>& type : isochrone.ByType){
+
+        out << "  " << this->amenityTypes[type.first] << " (" << type.second.size() << ")";
+
+        string separator = ": ";
+
+        for (pair<int, float> amenity : type.second){
+          if (!this->osmAmenities[amenity.first].getName().empty()){
+            out << separator << this->osmAmenities[amenity.first].getName();
+            separator = ", ";
+          }
+        }
+
+        out << '\n';
+      }
+    }
   }
 
   if (coordinates_list.size() < 1){
-    cout << "No such building" << endl;
+    out << "No such building" << '\n';
   }
-}
\ No newline at end of file
+}
+
+void Amenities::findNearestFastFoodWalking(const Buildings& buildings, const Nodes& nodes, const vector< pair < int, pair <double, double> > >& coordinates_list, ostream& out) const
+{
+  for (const pair < int, pair <double, double> >& coordinates: coordinates_list){
+    
+    float distance = -1;
+    string name = "";
+    string address = "";
+
+    int i = this->findNearestFastFoodWalking(buildings, nodes, coordinates.first, distance);
+
+    if (i >= 0){
+      name = this->osmAmenities[i].getName();
+      address = this->osmAmenities[i].getStreetAddress();
+    }
+
+    out << buildings.osmBuildings[coordinates.first].getName() << '\n';
+    out << name << " (fast_food): " << address << '\n';
+    out << " Walking distance: " << distance << " miles" << '\n';
+  }
+
+  if (coordinates_list.size() < 1){
+    out << "No such building" << '\n';
+  }
+}
@@ -9,17 +9,55 @@
 
 #pragma once
 
+#include <iostream>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+#include <memory_resource>
+#include <span>
+#include <mutex>
 
 #include "amenity.h"
 #include "buildings.h"
 #include "dist.h"
+#include "osm.h"
+#include "snapshot.h"
+#include "intern.h"
+#include "spatial.h"
+#include "graph.h"
+#include "hierarchy.h"
 #include "tinyxml2.h"
 
 using namespace std;
 using namespace tinyxml2;
 
 
+/**
+  * @brief what can be reached on foot within a given time, see
+  * Amenities::findWithinWalking.
+  */
+struct WalkingIsochrone
+{
+  double Minutes;
+
+  //
+  // the amenities within reach, grouped by type in order of type
+  // id: the type id, and the (position in osmAmenities, walking
+  // distance in miles) of each amenity of the type, nearest first:
+  //
+  vector<pair<int, vector<pair<int, float>>>> ByType;
+
+  //
+  // the outline of the area within reach, the convex hull of where
+  // the walk can get to along the paths, as (lat, lon) corners in
+  // counterclockwise order; empty unless asked for:
+  //
+  vector<pair<double, double>> Polygon;
+};
+
+
 /**
   * @brief A collection of amenities in the open street map.
   */
@@ -27,7 +65,39 @@ class Amenities
 {
 public:
   vector<Amenity> osmAmenities;
-  vector<string> amenityTypes;
+
+  //
+  // the dictionary of amenity types, each type once, alphabetically;
+  // the id of a type is its position here:
+  //
+  vector<string_view> amenityTypes;
+
+/**
+  * @brief default constructor, creates an empty collection.
+  *
+  * The collection is filled one element at a time by add( )
+  * while streaming through the map file, followed by a call
+  * to finishLoading( ).
+  */
+  Amenities();
+
+/**
+  * @brief creates an empty collection that keeps its text (names, addresses, types)
+  * in the given pool, and its indexes in the pool's arena, e.g.
+  * to share one pool between collections. By default each
+  * collection has a pool of its own.
+  *
+  * @param strings The pool.
+  */
+  explicit Amenities(shared_ptr<StringPool> strings);
+
+  // the amenities refer to the collection's own storage, so it is
+  // movable but cannot be copied; its containers are tied to its
+  // arena, so it can't be assigned either:
+  Amenities(const Amenities& other) = delete;
+  Amenities& operator=(const Amenities& other) = delete;
+  Amenities(Amenities&& other) = default;
+  Amenities& operator=(Amenities&& other) = delete;
 
 /**
   * @brief constructor to retrieve all the amenities from the open street map.
@@ -36,19 +106,313 @@ public:
   * stores all the amenities into the vector data member.
   * 
   * @param xmldoc An XML document object denoting the open street map.
+  * @param nodes The nodes of the map, already loaded.
+  * @return nothing.
+  */
+  Amenities(XMLDocument& xmldoc, Nodes& nodes);
+
+/**
+  * @brief stores the given element if it's a named amenity.
+  *
+  * @param elem A node or way from the open street map.
+  * @return nothing.
+  */
+  void add(const OsmElement& elem);
+
+/**
+  * @brief called once all elements have been added, resolves the
+  * amenities' node ids to indices in the node table, sorts the
+  * amenities by name and the amenity types alphabetically, and
+  * numbers the types.
+  *
+  * Node ids that are not in the map are dropped (and counted, see
+  * getNumMissingNodes), so the nodes of an amenity can be used
+  * without further lookups. Call this once, after the nodes have
+  * finished loading.
+  *
+  * @param nodes The nodes of the map, already loaded.
+  * @return nothing.
+  */
+  void finishLoading(Nodes& nodes);
+  
+/**
+  * @brief saves the amenities and amenity types to a snapshot.
+  *
+  * @param out The snapshot being written.
   * @return nothing.
   */
-  Amenities(XMLDocument& xmldoc);
+  void writeSnapshot(SnapshotWriter& out);
+
+/**
+  * @brief switches to using the amenities and amenity types of a (mapped) snapshot in place.
+  *
+  * @param snapshot The snapshot, which stays mapped while in use.
+  * @return nothing.
+  */
+  void readSnapshot(shared_ptr<Snapshot> snapshot);
+
+/**
+  * @brief # of node references that were not in the map.
+  *
+  * @return the # of node ids dropped by finishLoading.
+  */
+  int getNumMissingNodes() const;
+
+/**
+  * @brief the id of the given amenity type, e.g. "fast_food".
+  *
+  * @param amenityType The type of amenity.
+  * @return the position in amenityTypes, or -1 if there's no such type.
+  */
+  int getTypeID(string_view amenityType) const;
+
+/**
+  * @brief the amenities of the given type.
+  *
+  * @param typeID The id of the type, see getTypeID.
+  * @return the positions in osmAmenities, in order (empty if the
+  *   id is not valid)
+  */
+  span<const int> getAmenitiesOfType(int typeID) const;
+
+/**
+  * @brief the spatial index over the locations of the amenities of
+  * the given type, e.g. "fast_food".
+  *
+  * The items in the index are positions in osmAmenities.
+  *
+  * @param amenityType The type of amenity, or its id.
+  * @return the index, or nullptr if there are no such amenities.
+  */
+  const SpatialIndex* getSpatialIndex(string_view amenityType) const;
+  const SpatialIndex* getSpatialIndex(int typeID) const;
   
 /**
   * @brief prints all the amenities in summary form.
   *
+  * @param out Where to print, the console by default.
   * @return nothing
   */
-  void print();
+  void print(ostream& out = cout) const;
   void findAndPrint(Amenities& amenities, Nodes& nodes, int num_of_amenities);
-  void findNearestFastFood(Amenities& amenities, Buildings& buildings, Nodes& nodes, int num_of_amenities, vector< pair < int, pair <double, double> > > coordinates_list);
+  void findNearestFastFood(const Amenities& amenities, const Buildings& buildings, const Nodes& nodes, int num_of_amenities, vector< pair < int, pair <double, double> > > coordinates_list, ostream& out = cout) const;
+
+/**
+  * @brief the a command: prints every amenity whose type contains
+  * the given text (ignoring case) in detail, or all the amenity
+  * types if the text is empty.
+  *
+  * The interactive version above reads the text from the rest of
+  * the input line and prints to the console.
+  *
+  * @param amenity The text to search for; leading spaces are ignored.
+  * @param nodes The nodes of the map.
+  * @param out Where to print.
+  * @return nothing
+  */
+  void findAndPrint(string amenity, const Nodes& nodes, ostream& out) const;
+
+/**
+  * @brief the amenities whose type contains the given text,
+  * ignoring case.
+  *
+  * @param amenity The text to search for; leading spaces are ignored.
+  * @return the positions in osmAmenities, in order
+  */
+  vector<int> findByType(string amenity) const;
+
+/**
+  * @brief the fast food amenity nearest to the given location.
+  *
+  * @param lat Latitude of the location.
+  * @param lon Longitude of the location.
+  * @param distance Output: the distance in miles, -1 if none.
+  * @return the position in osmAmenities, -1 if there's no fast food
+  */
+  int findNearestFastFood(double lat, double lon, float& distance) const;
+
+/**
+  * @brief sets the walking graph used by the walking queries, and
+  * finds where each amenity joins it (see Graph::nearestVertex).
+  *
+  * Call once both the amenities and the graph have finished
+  * loading; the graph must not change while it's in use.
+  *
+  * @param graph The walking graph of the map.
+  * @return nothing.
+  */
+  void setGraph(const Graph& graph);
+
+/**
+  * @brief sets the contraction hierarchy of the walking graph, which
+  * the walking queries then use instead of searching the graph.
+  *
+  * Call after setGraph( ); the hierarchy must not change while
+  * it's in use. The amenities of each type are prepared as targets
+  * the first time a query needs them.
+  *
+  * @param hierarchy The hierarchy over the graph given to setGraph( ).
+  * @return nothing.
+  */
+  void setHierarchy(const ContractionHierarchy& hierarchy);
+
+/**
+  * @brief the fast food amenity nearest to a building by walking
+  * distance: findNearestWalking for one fast food, starting from
+  * the building's entrances (see Buildings::getWalkingSources).
+  *
+  * The walk goes in a straight line from an entrance to the nearest
+  * vertex of the graph, along the paths to the vertex nearest the
+  * fast food, and then in a straight line to it. Among fast food at
+  * the same distance the first one (by name) wins.
+  *
+  * @param buildings The buildings of the map.
+  * @param nodes The nodes of the map, for the building entrances.
+  * @param building The position of the building in osmBuildings.
+  * @param distance Output: the walking distance in miles, -1 if none.
+  * @return the position in osmAmenities, -1 if there's no fast food
+  *   (or no walking graph, or no way to walk to any)
+  */
+  int findNearestFastFoodWalking(const Buildings& buildings, const Nodes& nodes, int building, float& distance) const;
+
+/**
+  * @brief the walking distance from a building (or any set of
+  * starting points) to an amenity, by A* search (or a search of
+  * the hierarchy, if there is one).
+  *
+  * @param sources Where the walk starts: the vertices, and the
+  *   distance to each, see Buildings::getWalkingSources.
+  * @param amenity The position of the amenity in osmAmenities.
+  * @return the walking distance in miles, -1 if there's no walking
+  *   graph or no way to walk there
+  */
+  float findWalkingDistance(span<const pair<uint32_t, double>> sources, int amenity) const;
+
+/**
+  * @brief the k amenities of the given types nearest to a building
+  * (or any set of starting points) by walking distance.
+  *
+  * One Dijkstra search from all the starting points answers the
+  * query: the amenities are found as the search reaches where they
+  * join the graph, and it stops as soon as the k nearest are
+  * certain, rather than searching to each amenity in turn. With a
+  * hierarchy, it's one upward search over it per type instead.
+  *
+  * @param sources Where the walk starts: the vertices, and the
+  *   distance to each, see Buildings::getWalkingSources.
+  * @param typeIDs The types of amenity wanted, see getTypeID.
+  * @param k The # of amenities wanted.
+  * @return up to k (position in osmAmenities, walking distance in
+  *   miles), nearest first; among amenities at the same distance,
+  *   the first one (by name) comes first
+  */
+  vector<pair<int, float>> findNearestWalking(span<const pair<uint32_t, double>> sources, span<const int> typeIDs, size_t k) const;
+
+/**
+  * @brief the amenities within a few walking times of a building
+  * (or any set of starting points), e.g. 5, 10 and 15 minutes, at
+  * WALKING_SPEED.
+  *
+  * One Dijkstra search, out to the longest of the times, answers
+  * every time at once: each amenity is within the times its walking
+  * distance fits in.
+  *
+  * @param sources Where the walk starts: the vertices, and the
+  *   distance to each, see Buildings::getWalkingSources.
+  * @param minutes The walking times.
+  * @param withPolygons Whether to outline the area within each time.
+  * @return what's within each time, in the order of the times given
+  */
+  vector<WalkingIsochrone> findWithinWalking(span<const pair<uint32_t, double>> sources, span<const double> minutes, bool withPolygons = false) const;
+
+  static constexpr double WALKING_SPEED = 3.0;  // miles per hour
+
+/**
+  * @brief the i command: prints the amenities within a 5, 10 and
+  * 15 minute walk of each of the given buildings, by type.
+  *
+  * @param buildings The buildings of the map.
+  * @param nodes The nodes of the map, for the building entrances.
+  * @param coordinates_list The matching buildings, see Buildings::fast_food_search.
+  * @param out Where to print, the console by default.
+  * @return nothing
+  */
+  void findWithinWalking(const Buildings& buildings, const Nodes& nodes, const vector< pair < int, pair <double, double> > >& coordinates_list, ostream& out = cout) const;
+
+/**
+  * @brief the w command: prints the fast food nearest to each of
+  * the given buildings by walking distance, in the same form as
+  * the f command.
+  *
+  * @param buildings The buildings of the map.
+  * @param nodes The nodes of the map, for the building entrances.
+  * @param coordinates_list The matching buildings, see Buildings::fast_food_search.
+  * @param out Where to print, the console by default.
+  * @return nothing
+  */
+  void findNearestFastFoodWalking(const Buildings& buildings, const Nodes& nodes, const vector< pair < int, pair <double, double> > >& coordinates_list, ostream& out = cout) const;
+
+
+private:
+  //
+  // the text the amenities refer to, when loaded from the XML; may
+  // be shared with other collections. The containers below that
+  // last as long as the map are allocated from its arena:
+  //
+  shared_ptr<StringPool> Strings;
+
+  //
+  // while loading, the node ids of each amenity, as (offset, count)
+  // into PendingNodeIDs, in the same order as osmAmenities:
+  //
+  vector<long long> PendingNodeIDs;
+  vector<pair<size_t, size_t>> PendingRanges;
+
+  //
+  // the node indices of all the amenities, back to back; each 
+  // amenity refers to its part of this array:
+  //
+  pmr::vector<uint32_t> NodeIndices;
+  int NumMissingNodes;
+
+  //
+  // or, when loaded from a snapshot, the mapped snapshot itself:
+  //
+  shared_ptr<Snapshot> Mapped;
+
+  //
+  // by type id, built once the amenities and types are sorted: the
+  // lowercase type, the positions of the amenities of the type in
+  // osmAmenities, and a spatial index over them:
+  //
+  pmr::unordered_map<string_view, int> TypeIDs;
+  pmr::vector<string_view> LowerTypes;  // in the string pool
+  pmr::vector<pmr::vector<int>> TypePostings;
+  vector<SpatialIndex> SpatialIndexes;
+  int FastFoodTypeID;
+
+  //
+  // the walking graph, and where each amenity joins it: by position
+  // in osmAmenities, the vertex and the distance to it; and by type
+  // id, the (vertex, position) of the amenities of the type, sorted
+  // by vertex:
+  //
+  const Graph* WalkingGraph;
+  vector<int> GraphVertices;
+  vector<float> GraphDistances;
+  vector<vector<pair<uint32_t, int>>> TypeVertices;
+
+  //
+  // the contraction hierarchy of the graph, and by type id, the
+  // amenities of the type (in TypeVertices order) prepared as
+  // targets for it, on first use:
+  //
+  const ContractionHierarchy* Hierarchy;
+  mutable vector<HierarchyTargets> TypeTargets;
+  mutable unique_ptr<once_flag[]> TypeTargetsReady;
 
+  void buildTypeIndexes();
+  const HierarchyTargets& getTypeTargets(int typeID) const;
 };
 
 
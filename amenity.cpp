@@ -24,58 +24,81 @@ using namespace std;
 //
 // constructor
 //
-Amenity::Amenity(long long id, string name, string streetAddr, string amenityType)
-  : ID(id), Name(name), StreetAddress(streetAddr), AmenityType(amenityType)
+Amenity::Amenity(long long id, string_view name, string_view streetAddr, string_view amenityType, span<const uint32_t> nodeIndices)
+  : ID(id), Name(name), StreetAddress(streetAddr), AmenityType(amenityType), TypeID(-1), NodeIndices(nodeIndices),
+    Location(0, 0), Bounds{0, 0, 0, 0}
 {
-  // vector is default initialized by its constructor
 }
 
 
 //
-// adds the given nodeid to the end of the vector.
+// sets the indices (in the node table) of the nodes that define
+// the position / outline.
 //
-void Amenity::add(long long nodeid)
+void Amenity::setNodeIndices(span<const uint32_t> nodeIndices)
 {
-  this->NodeIDs.push_back(nodeid);
+  this->NodeIndices = nodeIndices;
 }
 
 
 //
-// prints information about this amenity to the console
+// sets the id of the amenity type.
 //
-void Amenity::print()  // summary
+void Amenity::setTypeID(int typeID)
+{
+  this->TypeID = typeID;
+}
+
+
+//
+// computes the location (the average of the nodes' positions) and
+// the bounding box, so the queries don't have to visit the nodes.
+//
+void Amenity::setGeometry(const NodeTable& table)
+{
+  this->Location = table.getCentroid(this->NodeIndices);
+  this->Bounds = table.getBounds(this->NodeIndices);
+}
+
+
+//
+// prints information about this amenity to the console (or the
+// given stream)
+//
+void Amenity::print(ostream& out) const  // summary
 {
   //
   // print a simple one line summary of amenity:
   //
-  cout << this->Name << " (" << AmenityType << ")" << ": "
+  out << this->Name << " (" << AmenityType << ")" << ": "
        << this->StreetAddress
-       << endl;
+       << '\n';
        
   return;
 }
 
-void Amenity::print(Nodes &nodes)  // detailed
+void Amenity::print(const Nodes& nodes, ostream& out) const  // detailed
 {
   //
   // print a more complete, detailed output of amenity:
   //
-  cout << this->Name << " (" << AmenityType << ")" << endl;
-  cout << " OSM ID: " << this->ID << endl;
-  cout << " Address: " << this->StreetAddress << endl;
+  out << this->Name << " (" << AmenityType << ")" << '\n';
+  out << " OSM ID: " << this->ID << '\n';
+  out << " Address: " << this->StreetAddress << '\n';
   
   // implement getLocation() function, call here, and output
   // returned latitude and longitude:
 
-  pair<double, double> avg_location = getLocation(nodes);
-  cout << " GPS Location: " << avg_location.first << ", " << avg_location.second << endl;
+  pair<double, double> avg_location = getLocation();
+  out << " GPS Location: " << avg_location.first << ", " << avg_location.second << '\n';
 
  
-  // loop through the sorted nodeids, and for each id, call
-  // the find( ) function in the Nodes class to obtain
+  // loop through the nodes in order of id, and output their
   // latitude, longitude, and whether it's an entrance or not.
-  //
-  // If the find( ) function returns false, output "**NODE NOT FOUND**"
+  // The node indices were resolved when the map was loaded (and
+  // nodes that are not in the map were dropped), so this reads 
+  // straight from the node table. The table is sorted by id, so
+  // sorting the indices sorts by id.
   //
   // output format:
   //   id: (latitude, longitude)
@@ -84,22 +107,24 @@ void Amenity::print(Nodes &nodes)  // detailed
   // where each line has 2 leading spaces
   //
 
-  cout << " Nodes:" << endl;
+  out << " Nodes:" << '\n';
     
-  vector<long long> sorted = this->getNodeIDs();
-
-  for (long long id : sorted){
-    double lat = 0;
-    double lon = 0;
-    bool isEntrance = false;
-    bool check = nodes.find(id, lat, lon, isEntrance);
-    if (check){  
-      if (isEntrance){
-          cout << "  " << id << ": " << "(" << lat << ", " << lon << "), is entrance" << endl;
-      }
-      else {   
-        cout << "  " << id << ": " << "(" << lat << ", " << lon << ")" << endl;
-      }
+  NodeTable table = nodes.getTable();
+
+  vector<uint32_t> sorted(this->NodeIndices.begin(), this->NodeIndices.end());
+
+  std::sort(sorted.begin(), sorted.end());
+
+  for (uint32_t i : sorted){
+    long long id = table.IDs[i];
+    double lat = table.getLat(i);
+    double lon = table.getLon(i);
+
+    if (table.getIsEntrance(i)){
+      out << "  " << id << ": " << "(" << lat << ", " << lon << "), is entrance" << '\n';
+    }
+    else {   
+      out << "  " << id << ": " << "(" << lat << ", " << lon << ")" << '\n';
     }
   }
    
@@ -110,50 +135,46 @@ void Amenity::print(Nodes &nodes)  // detailed
 //
 // getters:
 //
-long long Amenity::getID() 
+long long Amenity::getID() const
 { return this->ID; }
 
-string Amenity::getName()
+string_view Amenity::getName() const
 { return this->Name; }
 
-string Amenity::getStreetAddress()
+string_view Amenity::getStreetAddress() const
 { return this->StreetAddress; }
 
-string Amenity::getAmenityType()
+string_view Amenity::getAmenityType() const
 { return this->AmenityType; }
 
+int Amenity::getTypeID() const
+{ return this->TypeID; }
+
+// returns the node indices in their original order, without copying
+span<const uint32_t> Amenity::getNodeIndices() const
+{ return this->NodeIndices; }
+
 // returns a sorted copy of the node ids
-vector<long long> Amenity::getNodeIDs()
+vector<long long> Amenity::getNodeIDs(const Nodes& nodes) const
 { 
-  vector<long long> copy = this->NodeIDs;
+  NodeTable table = nodes.getTable();
+
+  vector<long long> copy;
+  
+  for (uint32_t i : this->NodeIndices) {
+    copy.push_back(table.IDs[i]);
+  }
   
   std::sort(copy.begin(), copy.end());
   
   return copy;
 }
 
-pair<double, double> Amenity::getLocation(Nodes &nodes)
-{
+// returns the location computed by setGeometry, the average of
+// the nodes' positions
+pair<double, double> Amenity::getLocation() const
+{ return this->Location; }
 
-    double lat_total = 0;
-    double lon_total = 0;
-    double length = 0;
-  
-  for (long long id : NodeIDs){
-    double lat = 0;
-    double lon = 0;
-    bool isEntrance = false;
-    bool check = nodes.find(id, lat, lon, isEntrance);
-    if (check){  
-      lat_total += lat;
-      lon_total += lon;
-      length += 1;
-    }
-  }
-
-  double avg_lat = lat_total / length;
-  double avg_lon = lon_total / length;
-
-  return make_pair(avg_lat, avg_lon);
-
-}
+// returns the bounding box computed by setGeometry
+BoundingBox Amenity::getBounds() const
+{ return this->Bounds; }
@@ -14,9 +14,13 @@
 
 #pragma once
 
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <span>
 #include <utility>
+#include <cstdint>
 
 #include "nodes.h"
 
@@ -36,28 +40,44 @@ class Amenity
 {
 private:
   long long ID;
-  string    Name;
-  string    StreetAddress;
-  string    AmenityType;
-  vector<long long> NodeIDs;
+  string_view Name;
+  string_view StreetAddress;
+  string_view AmenityType;
+  int TypeID;                        // position in Amenities::amenityTypes
+  span<const uint32_t> NodeIndices;  // into the node table
+  pair<double, double> Location;     // average (lat, lon) of the nodes
+  BoundingBox Bounds;
 
 public:
-  // constructor
-  Amenity(long long id, string name, string streetAddr, string amenityType);
+  // constructor; the strings and node indices are not copied, they
+  // belong to the Amenities collection (or its snapshot)
+  Amenity(long long id, string_view name, string_view streetAddr, string_view amenityType, span<const uint32_t> nodeIndices);
 
-  // adds the given nodeid to the end of the vector
-  void add(long long nodeid);
+  // sets the indices (in the node table) of the nodes that
+  // define the position / outline
+  void setNodeIndices(span<const uint32_t> nodeIndices);
+
+  // sets the id of the amenity type, in the dictionary of types
+  // kept by the Amenities collection
+  void setTypeID(int typeID);
+
+  // computes the location and bounding box from the nodes, once
+  // the node indices are set; the getters below return these
+  void setGeometry(const NodeTable& table);
 
   // prints amenity information to the console
-  void print();  // summary
-  void print(Nodes& nodes);
+  void print(ostream& out = cout) const;  // summary
+  void print(const Nodes& nodes, ostream& out = cout) const;  // detailed
   
   // getters:
-  long long getID();
-  string    getName();
-  string    getStreetAddress();
-  string    getAmenityType();
-  vector<long long> getNodeIDs(); // returns a sorted copy of the node ids
-  pair<double, double> getLocation(Nodes& nodes);
+  long long getID() const;
+  string_view getName() const;
+  string_view getStreetAddress() const;
+  string_view getAmenityType() const;
+  int getTypeID() const;  // set by setTypeID, -1 until then
+  span<const uint32_t> getNodeIndices() const;  // in their original order
+  vector<long long> getNodeIDs(const Nodes& nodes) const; // returns a sorted copy of the node ids
+  pair<double, double> getLocation() const;  // computed by setGeometry
+  BoundingBox getBounds() const;
 };
 
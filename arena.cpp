@@ -0,0 +1,109 @@
+/*arena.cpp*/
+
+//
+// Bump allocator for the data of a loaded map: memory comes from
+// large blocks and is only freed when the arena is destroyed.
+//
+// Jay Rao
+// Northwestern University
+// CS 211
+//
+
+#include <new>
+#include <algorithm>
+#include <cstdint>
+
+#include "arena.h"
+
+using namespace std;
+
+
+static const size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+
+//
+// constructor
+//
+Arena::Arena(size_t blockSize)
+  : Next(nullptr), Left(0), BlockSize(max(blockSize, (size_t) 64)), NumBytes(0)
+{
+}
+
+
+//
+// destructor
+//
+Arena::~Arena()
+{
+  for (void* block : this->Blocks) {
+    ::operator delete(block);
+  }
+}
+
+
+//
+// getNumBlocks
+//
+size_t Arena::getNumBlocks() const
+{
+  return this->Blocks.size();
+}
+
+
+//
+// getNumBytes
+//
+size_t Arena::getNumBytes() const
+{
+  return this->NumBytes;
+}
+
+
+//
+// do_allocate
+//
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+  //
+  // align the free space, and take a new block if what's left of
+  // this one isn't enough:
+  //
+  size_t padding = (alignment - (uintptr_t) this->Next % alignment) % alignment;
+
+  if (this->Next == nullptr || padding + bytes > this->Left)
+  {
+    size_t size = max(this->BlockSize, bytes + alignment);
+
+    this->Blocks.push_back(::operator new(size));
+    this->Next = (char*) this->Blocks.back();
+    this->Left = size;
+    this->BlockSize = min(this->BlockSize * 2, MAX_BLOCK_SIZE);
+
+    padding = (alignment - (uintptr_t) this->Next % alignment) % alignment;
+  }
+
+  void* p = this->Next + padding;
+
+  this->Next += padding + bytes;
+  this->Left -= padding + bytes;
+  this->NumBytes += bytes;
+
+  return p;
+}
+
+
+//
+// do_deallocate: nothing, the memory is freed with the arena
+//
+void Arena::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+}
+
+
+//
+// do_is_equal: memory from one arena can't be freed by another
+//
+bool Arena::do_is_equal(const pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
@@ -0,0 +1,69 @@
+/*arena.h*/
+
+/**
+  * @brief bump allocator for the data of a loaded map.
+  *
+  * Memory is handed out from large blocks, one after another, and
+  * is never freed piece by piece: everything goes at once when the
+  * arena is destroyed. The map is built once and then only read,
+  * so this turns the many small allocations of loading (strings,
+  * index entries, posting lists) into a few large ones, and
+  * teardown into freeing a few blocks.
+  *
+  * The arena is a std::pmr::memory_resource, so any pmr container
+  * can be given one, e.g. pmr::vector<int> v(&arena).
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+
+/**
+  * @brief bump allocator for the data of a loaded map.
+  *
+  * Not thread-safe: allocate from one thread at a time. Containers
+  * using an arena must be destroyed before it; deallocating does
+  * nothing, but is still a call to the arena.
+  */
+class Arena : public pmr::memory_resource
+{
+public:
+/**
+  * @brief creates an empty arena; no memory is taken until the
+  * first allocation.
+  *
+  * @param blockSize The size of the first block; later blocks
+  *   double in size, up to 1 MB.
+  */
+  explicit Arena(size_t blockSize = 64 * 1024);
+
+  // frees all the blocks:
+  ~Arena();
+
+  Arena(const Arena& other) = delete;
+  Arena& operator=(const Arena& other) = delete;
+
+  // the # of blocks taken from the system, and the # of bytes
+  // handed out from them:
+  size_t getNumBlocks() const;
+  size_t getNumBytes() const;
+
+private:
+  vector<void*> Blocks;
+  char*  Next;       // free space in the last block
+  size_t Left;
+  size_t BlockSize;  // of the next block
+  size_t NumBytes;
+
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void  do_deallocate(void* p, size_t bytes, size_t alignment) override;
+  bool  do_is_equal(const pmr::memory_resource& other) const noexcept override;
+};
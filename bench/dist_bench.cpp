@@ -0,0 +1,181 @@
+/*dist_bench.cpp*/
+
+/**
+  * @brief benchmark for computing distances in bulk.
+  *
+  * Computes the distances from one point to many random points
+  * around Chicago three ways: a loop calling distBetween2Points,
+  * distFromPointScalar, and distFromPoint (which uses AVX2 or
+  * AVX-512 if the CPU has them). Reports the time per distance
+  * and how far distFromPoint's results are from the exact ones.
+  *
+  * Then times distApprox, checks its error bound on every point,
+  * and checks that ranking by distApprox and refining the few
+  * candidates within the error bound finds the same nearest point
+  * as ranking by distBetween2Points.
+  *
+  * Usage: bench/dist.out [# of points] [# of repetitions]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "dist.h"
+
+using namespace std;
+
+
+//
+// times reps calls of the given function, returning nanoseconds
+// per distance:
+//
+template <typename FN>
+static double timeDistances(size_t n, size_t reps, FN fn)
+{
+  auto start = chrono::steady_clock::now();
+
+  for (size_t r = 0; r < reps; r++) {
+    fn();
+  }
+
+  auto stop = chrono::steady_clock::now();
+
+  return chrono::duration<double, nano>(stop - start).count() / (n * reps);
+}
+
+
+int main(int argc, char* argv[])
+{
+  size_t n = (argc > 1) ? stoul(argv[1]) : 100000;
+  size_t reps = (argc > 2) ? stoul(argv[2]) : 50;
+
+  mt19937_64 rng(211);
+  uniform_real_distribution<double> lats(41.5, 42.2);
+  uniform_real_distribution<double> lons(-88.2, -87.5);
+
+  vector<double> destLats(n);
+  vector<double> destLons(n);
+
+  for (size_t i = 0; i < n; i++) {
+    destLats[i] = lats(rng);
+    destLons[i] = lons(rng);
+  }
+
+  double lat = 42.0565, lon = -87.6753;  // Mudd
+
+  vector<double> exact(n);
+  vector<double> scalar(n);
+  vector<double> batch(n);
+
+  double loopTime = timeDistances(n, reps, [&]()
+  {
+    for (size_t i = 0; i < n; i++) {
+      exact[i] = distBetween2Points(lat, lon, destLats[i], destLons[i]);
+    }
+  });
+
+  double scalarTime = timeDistances(n, reps, [&]()
+  {
+    distFromPointScalar(lat, lon, destLats.data(), destLons.data(), n, scalar.data());
+  });
+
+  double batchTime = timeDistances(n, reps, [&]()
+  {
+    distFromPoint(lat, lon, destLats.data(), destLons.data(), n, batch.data());
+  });
+
+  //
+  // accuracy, relative to distBetween2Points:
+  //
+  double maxRelError = 0;
+  double maxAbsError = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    double error = fabs(batch[i] - exact[i]);
+
+    maxAbsError = max(maxAbsError, error);
+    maxRelError = max(maxRelError, error / exact[i]);
+  }
+
+  cout << "** batch distance benchmark **" << endl;
+  cout << "points: " << n << ", repetitions: " << reps << endl;
+  cout << endl;
+  cout << "distBetween2Points:  " << loopTime << " ns/distance" << endl;
+  cout << "distFromPointScalar: " << scalarTime << " ns/distance"
+       << (scalar == exact ? " (identical)" : " (DIFFERENT)") << endl;
+  cout << "distFromPoint:       " << batchTime << " ns/distance (" << distFromPointKernel() << ")" << endl;
+  cout << "max error: " << maxAbsError << " miles, " << maxRelError << " relative" << endl;
+
+  //
+  // approximate distances:
+  //
+  vector<double> approx(n);
+  vector<double> bounds(n);
+
+  double approxTime = timeDistances(n, reps, [&]()
+  {
+    for (size_t i = 0; i < n; i++) {
+      approx[i] = distApprox(lat, lon, destLats[i], destLons[i], bounds[i]);
+    }
+  });
+
+  size_t violations = 0;
+  double maxApproxError = 0;
+  double maxBound = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    double error = fabs(approx[i] - exact[i]);
+
+    violations += (error > bounds[i]) ? 1 : 0;
+    maxApproxError = max(maxApproxError, error);
+    maxBound = max(maxBound, bounds[i]);
+  }
+
+  //
+  // nearest by approximate distance: the candidates are those 
+  // whose lower bound is under the best upper bound, and only 
+  // they get the exact distance:
+  //
+  double bestUpper = numeric_limits<double>::infinity();
+
+  for (size_t i = 0; i < n; i++) {
+    bestUpper = min(bestUpper, approx[i] + bounds[i]);
+  }
+
+  size_t refined = 0;
+  size_t nearestApprox = 0;
+  double nearestDistance = numeric_limits<double>::infinity();
+
+  for (size_t i = 0; i < n; i++) {
+    if (approx[i] - bounds[i] <= bestUpper) {
+      refined++;
+
+      double d = distBetween2Points(lat, lon, destLats[i], destLons[i]);
+
+      if (d < nearestDistance) {
+        nearestDistance = d;
+        nearestApprox = i;
+      }
+    }
+  }
+
+  size_t nearestExact = min_element(exact.begin(), exact.end()) - exact.begin();
+
+  cout << endl;
+  cout << "distApprox:          " << approxTime << " ns/distance" << endl;
+  cout << "max error: " << maxApproxError << " miles (bound up to " << maxBound << ", " 
+       << violations << " violations)" << endl;
+  cout << "nearest: " << refined << " candidate(s) refined, " 
+       << (nearestApprox == nearestExact ? "same" : "DIFFERENT") << " as exact" << endl;
+
+  return 0;
+}
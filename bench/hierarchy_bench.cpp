@@ -0,0 +1,194 @@
+/*hierarchy_bench.cpp*/
+
+/**
+  * @brief benchmark for the contraction hierarchy.
+  *
+  * Builds the walking graph and its contraction hierarchy from the
+  * map, reporting the time to build and the # of shortcuts. Then,
+  * from the entrances of every building, finds the walking distance
+  * to every amenity at once: with a Dijkstra search of the whole
+  * graph, and with one upward search of the hierarchy against the
+  * amenities prepared as targets. Reports the time per building for
+  * each, and checks they find the same distances.
+  *
+  * Usage: bench/hierarchy.out [# of repetitions]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "osm.h"
+
+using namespace std;
+
+
+int main(int argc, char* argv[])
+{
+  int reps = (argc > 1) ? stoi(argv[1]) : 20;
+
+  string filename = "nu.osm";
+
+  Nodes nodes;
+  Buildings buildings;
+  Amenities amenities;
+  Graph graph;
+  ContractionHierarchy hierarchy;
+
+  bool success = osmStreamMappedFile(filename,
+    [&](const OsmElement& elem)
+    {
+      nodes.add(elem);
+      buildings.add(elem);
+      amenities.add(elem);
+      graph.add(elem);
+    });
+
+  if (!success) {
+    return 0;
+  }
+
+  nodes.finishLoading();
+  buildings.finishLoading(nodes);
+  amenities.finishLoading(nodes);
+  graph.finishLoading(nodes);
+
+  auto start = chrono::steady_clock::now();
+
+  hierarchy.build(graph);
+
+  auto stop = chrono::steady_clock::now();
+
+  size_t numEdges = graph.getNumEdges() / 2;
+  size_t numShortcuts = hierarchy.getUpwardGraph().getNumEdges() - numEdges;
+
+  cout << "** contraction hierarchy benchmark: " << filename << " **" << endl;
+  cout << "graph: " << numEdges << " edges, build: "
+       << chrono::duration<double, milli>(stop - start).count() << " ms, "
+       << numShortcuts << " shortcuts" << endl;
+
+  //
+  // every amenity is a target:
+  //
+  vector<pair<uint32_t, double>> targets;
+
+  for (const Amenity& A : amenities.osmAmenities)
+  {
+    pair<double, double> location = A.getLocation();
+    double distance;
+    int vertex = graph.nearestVertex(location.first, location.second, distance);
+
+    targets.push_back(make_pair((uint32_t) max(vertex, 0), distance));
+  }
+
+  GraphSearch search;
+  HierarchyTargets prepared;
+
+  start = chrono::steady_clock::now();
+
+  hierarchy.prepareTargets(targets, prepared, search);
+
+  stop = chrono::steady_clock::now();
+
+  cout << "targets: " << targets.size() << " amenities, prepared in "
+       << chrono::duration<double, micro>(stop - start).count() << " us ("
+       << prepared.Buckets.size() << " bucket entries)" << endl;
+  cout << endl;
+
+  vector<vector<pair<uint32_t, double>>> sources;
+
+  for (size_t b = 0; b < buildings.osmBuildings.size(); b++) {
+    sources.push_back(buildings.getWalkingSources((int) b, nodes, graph));
+  }
+
+  //
+  // Dijkstra over the whole graph:
+  //
+  vector<vector<double>> expected(sources.size());
+  size_t settled = 0;
+
+  start = chrono::steady_clock::now();
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (size_t b = 0; b < sources.size(); b++)
+    {
+      uint32_t vertex;
+      double distance;
+
+      search.start(graph);
+
+      for (pair<uint32_t, double> source : sources[b]) {
+        search.addSource(source.first, source.second);
+      }
+
+      while (search.next(vertex, distance)) { }
+
+      settled += search.getNumSettled();
+
+      expected[b].clear();
+
+      for (pair<uint32_t, double> target : targets) {
+        expected[b].push_back(search.getDistance(target.first) + target.second);
+      }
+    }
+  }
+
+  stop = chrono::steady_clock::now();
+
+  size_t numQueries = reps * sources.size();
+
+  cout << "dijkstra:  " << (double) settled / numQueries << " settled/building, "
+       << chrono::duration<double, micro>(stop - start).count() / numQueries << " us/building" << endl;
+
+  //
+  // one upward search per building:
+  //
+  vector<double> distances;
+  size_t same = 0;
+
+  settled = 0;
+
+  start = chrono::steady_clock::now();
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (size_t b = 0; b < sources.size(); b++)
+    {
+      hierarchy.findDistances(sources[b], prepared, distances, search);
+
+      settled += search.getNumSettled();
+
+      if (r == 0)
+      {
+        bool ok = true;
+
+        for (size_t t = 0; t < targets.size(); t++) {
+          ok = ok && (distances[t] == expected[b][t] ||
+            fabs(distances[t] - expected[b][t]) <= 1e-6 * max(1.0, expected[b][t]));
+        }
+
+        same += ok ? 1 : 0;
+      }
+    }
+  }
+
+  stop = chrono::steady_clock::now();
+
+  cout << "hierarchy: " << (double) settled / numQueries << " settled/building, "
+       << chrono::duration<double, micro>(stop - start).count() / numQueries << " us/building"
+       << (same == sources.size() ? "" : " (DIFFERENT distances)") << endl;
+
+  return 0;
+}
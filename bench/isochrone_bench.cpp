@@ -0,0 +1,219 @@
+/*isochrone_bench.cpp*/
+
+/**
+  * @brief benchmark for walking isochrones.
+  *
+  * Loads the map and its walking graph, and from the entrances of
+  * every building finds the amenities within a 5, 10 and 15 minute
+  * walk: with one search per time, and with one search for all
+  * three (Amenities::findWithinWalking). Reports the time per
+  * building for each and checks they find the same amenities, then
+  * the time with the outlines, and checks every vertex within a
+  * time is inside its outline.
+  *
+  * Usage: bench/isochrone.out [# of repetitions]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "osm.h"
+#include "snapshot.h"
+
+using namespace std;
+
+
+//
+// is the point inside (or on) the counterclockwise polygon?
+//
+static bool inside(const vector<pair<double, double>>& polygon, double lat, double lon)
+{
+  if (polygon.size() < 3) {
+    return true;  // degenerate, nothing to check
+  }
+
+  for (size_t i = 0; i < polygon.size(); i++)
+  {
+    const pair<double, double>& a = polygon[i];
+    const pair<double, double>& b = polygon[(i + 1) % polygon.size()];
+
+    if ((b.second - a.second) * (lat - a.first) - (b.first - a.first) * (lon - a.second) < -1e-12) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+  int reps = (argc > 1) ? stoi(argv[1]) : 20;
+
+  string filename = "nu.osm";
+
+  Nodes nodes;
+  Buildings buildings;
+  Amenities amenities;
+  Graph graph;
+  ContractionHierarchy hierarchy;
+
+  if (!snapshotLoad(filename + ".snap", filename, nodes, buildings, amenities, graph, hierarchy))
+  {
+    bool success = osmStreamMappedFile(filename,
+      [&](const OsmElement& elem)
+      {
+        nodes.add(elem);
+        buildings.add(elem);
+        amenities.add(elem);
+        graph.add(elem);
+      });
+
+    if (!success) {
+      return 0;
+    }
+
+    nodes.finishLoading();
+    buildings.finishLoading(nodes);
+    amenities.finishLoading(nodes);
+    graph.finishLoading(nodes);
+  }
+
+  amenities.setGraph(graph);
+
+  const double MINUTES[] = { 5, 10, 15 };
+
+  vector<vector<pair<uint32_t, double>>> sources;
+
+  for (size_t b = 0; b < buildings.osmBuildings.size(); b++) {
+    sources.push_back(buildings.getWalkingSources((int) b, nodes, graph));
+  }
+
+  cout << "** walking isochrone benchmark: " << filename << " **" << endl;
+  cout << "graph: " << graph.getNumEdges() << " edges, buildings: " << sources.size()
+       << ", times: 5, 10, 15 minutes" << endl;
+  cout << endl;
+
+  //
+  // one search per time:
+  //
+  vector<vector<WalkingIsochrone>> expected(sources.size());
+
+  auto start = chrono::steady_clock::now();
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (size_t b = 0; b < sources.size(); b++)
+    {
+      expected[b].clear();
+
+      for (double minutes : MINUTES) {
+        expected[b].push_back(amenities.findWithinWalking(sources[b], span<const double>(&minutes, 1))[0]);
+      }
+    }
+  }
+
+  auto stop = chrono::steady_clock::now();
+
+  size_t numQueries = reps * sources.size();
+
+  cout << "search per time: "
+       << chrono::duration<double, micro>(stop - start).count() / numQueries << " us/building" << endl;
+
+  //
+  // one search for all the times:
+  //
+  size_t same = 0;
+
+  start = chrono::steady_clock::now();
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (size_t b = 0; b < sources.size(); b++)
+    {
+      vector<WalkingIsochrone> isochrones = amenities.findWithinWalking(sources[b], MINUTES);
+
+      if (r == 0)
+      {
+        bool ok = true;
+
+        for (size_t i = 0; i < isochrones.size(); i++) {
+          ok = ok && (isochrones[i].ByType == expected[b][i].ByType);
+        }
+
+        same += ok ? 1 : 0;
+      }
+    }
+  }
+
+  stop = chrono::steady_clock::now();
+
+  cout << "one search:      "
+       << chrono::duration<double, micro>(stop - start).count() / numQueries << " us/building"
+       << (same == sources.size() ? "" : " (DIFFERENT amenities)") << endl;
+
+  //
+  // with the outlines:
+  //
+  size_t corners = 0;
+  size_t outside = 0;
+
+  start = chrono::steady_clock::now();
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (size_t b = 0; b < sources.size(); b++)
+    {
+      vector<WalkingIsochrone> isochrones = amenities.findWithinWalking(sources[b], MINUTES, true);
+
+      for (const WalkingIsochrone& isochrone : isochrones) {
+        corners += isochrone.Polygon.size();
+      }
+
+      if (r > 0) {
+        continue;
+      }
+
+      GraphSearch search;
+      uint32_t vertex;
+      double walked;
+
+      search.start(graph);
+
+      for (pair<uint32_t, double> source : sources[b]) {
+        search.addSource(source.first, source.second);
+      }
+
+      while (search.next(vertex, walked))
+      {
+        for (const WalkingIsochrone& isochrone : isochrones)
+        {
+          if (walked <= isochrone.Minutes / 60.0 * Amenities::WALKING_SPEED &&
+              !inside(isochrone.Polygon, graph.getLat(vertex), graph.getLon(vertex))) {
+            outside++;
+          }
+        }
+      }
+    }
+  }
+
+  stop = chrono::steady_clock::now();
+
+  cout << "with outlines:   "
+       << chrono::duration<double, micro>(stop - start).count() / numQueries << " us/building, "
+       << (double) corners / numQueries / 3 << " corners/outline"
+       << (outside == 0 ? "" : " (vertices OUTSIDE their outline)") << endl;
+
+  return 0;
+}
@@ -0,0 +1,183 @@
+/*lookup_bench.cpp*/
+
+/**
+  * @brief benchmark for looking up nodes by id.
+  *
+  * Compares Nodes::find, which searches a flat array of node 
+  * records sorted by id, against the std::map<long long, Node>
+  * the collection used to keep: lookup latency for ids that are
+  * found and ids that are not, and heap memory per node (as 
+  * measured by malloc).
+  *
+  * Usage: bench/lookup.out [mapfile] [# of lookups]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <malloc.h>
+
+#include "nodes.h"
+#include "osm.h"
+
+using namespace std;
+
+
+//
+// bytes currently allocated on the heap:
+//
+static size_t heapInUse()
+{
+  return mallinfo2().uordblks;
+}
+
+//
+// times the given lookup function over all the ids, returning
+// nanoseconds per lookup; the # of ids found is returned via
+// found so the compiler cannot skip the work:
+//
+template <typename LOOKUP>
+static double timeLookups(const vector<long long>& ids, LOOKUP lookup, long long& found)
+{
+  found = 0;
+
+  auto start = chrono::steady_clock::now();
+
+  for (long long id : ids) {
+    found += lookup(id) ? 1 : 0;
+  }
+
+  auto stop = chrono::steady_clock::now();
+
+  return chrono::duration<double, nano>(stop - start).count() / ids.size();
+}
+
+
+int main(int argc, char* argv[])
+{
+  string filename = (argc > 1) ? argv[1] : "nu.osm";
+  size_t numLookups = (argc > 2) ? stoul(argv[2]) : 2000000;
+
+  //
+  // read the nodes once, so both indexes are built from the same
+  // data without parsing in the measured window:
+  //
+  vector<OsmElement> elements;
+
+  bool success = osmStreamMappedFile(filename, 
+    [&](const OsmElement& elem)
+    {
+      if (elem.ElemKind == OsmElement::NODE) {
+        elements.push_back(elem);
+      }
+    }
+  );
+
+  if (!success) {
+    return 0;
+  }
+
+  //
+  // build both indexes, measuring the heap each one uses:
+  //
+  size_t before = heapInUse();
+
+  map<long long, Node> tree;
+
+  for (const OsmElement& elem : elements) {
+    tree.emplace(elem.ID, Node(elem.ID, elem.Lat, elem.Lon, false));
+  }
+
+  size_t treeBytes = heapInUse() - before;
+
+  before = heapInUse();
+
+  Nodes nodes;
+
+  for (const OsmElement& elem : elements) {
+    nodes.add(elem);
+  }
+
+  nodes.finishLoading();
+
+  size_t flatBytes = heapInUse() - before;
+
+  size_t n = elements.size();
+
+  //
+  // lookups of random ids that exist, and of ids that don't:
+  //
+  mt19937_64 rng(211);
+  vector<long long> hits(numLookups);
+  vector<long long> misses(numLookups);
+
+  long long minID = tree.begin()->first;
+  long long maxID = tree.rbegin()->first;
+
+  for (size_t i = 0; i < numLookups; i++)
+  {
+    hits[i] = elements[rng() % n].ID;
+
+    //
+    // random id in the same range that is not a node:
+    //
+    do {
+      misses[i] = minID + (long long) (rng() % (maxID - minID));
+    } while (tree.count(misses[i]) > 0);
+  }
+
+  cout << "** node lookup benchmark: " << filename << " **" << endl;
+  cout << "nodes: " << n << ", lookups: " << numLookups << endl;
+  cout << endl;
+
+  long long found = 0;
+  long long totalFound = 0;
+  double lat, lon;
+  bool entrance;
+
+  //
+  // the map lookup returns the node's data too, like Nodes::find:
+  //
+  auto treeFind = [&](long long id) -> bool
+  {
+    map<long long, Node>::iterator iter = tree.find(id);
+
+    if (iter == tree.end()) {
+      return false;
+    }
+
+    lat = iter->second.getLat();
+    lon = iter->second.getLon();
+    entrance = iter->second.getIsEntrance();
+    return true;
+  };
+
+  auto flatFind = [&](long long id) -> bool
+  {
+    return nodes.find(id, lat, lon, entrance);
+  };
+
+  double treeHit = timeLookups(hits, treeFind, found);
+  totalFound += found;
+  double treeMiss = timeLookups(misses, treeFind, found);
+  totalFound += found;
+  double flatHit = timeLookups(hits, flatFind, found);
+  totalFound += found;
+  double flatMiss = timeLookups(misses, flatFind, found);
+  totalFound += found;
+
+  cout << "std::map:    " << treeHit << " ns/hit, " << treeMiss << " ns/miss, "
+       << (double) treeBytes / n << " bytes/node" << endl;
+  cout << "Nodes::find: " << flatHit << " ns/hit, " << flatMiss << " ns/miss, "
+       << (double) flatBytes / n << " bytes/node" << endl;
+  cout << "(found " << totalFound << ")" << endl;
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*nearest_bench.cpp*/
+
+/**
+  * @brief benchmark for nearest-point and radius queries.
+  *
+  * Scatters random points of interest over a metro-sized area
+  * (around Chicago) and compares SpatialIndex against a linear
+  * scan calling distBetween2Points for every point: the time per
+  * nearest-neighbour query, per 10-nearest query, and per radius
+  * query. The answers of the two are checked against each other.
+  *
+  * Usage: bench/nearest.out [# of points] [# of queries]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include "spatial.h"
+#include "dist.h"
+
+using namespace std;
+
+
+//
+// times the given query function over all the query points,
+// returning microseconds per query:
+//
+template <typename QUERY>
+static double timeQueries(const vector<pair<double, double>>& queries, QUERY query)
+{
+  auto start = chrono::steady_clock::now();
+
+  for (const pair<double, double>& q : queries) {
+    query(q.first, q.second);
+  }
+
+  auto stop = chrono::steady_clock::now();
+
+  return chrono::duration<double, micro>(stop - start).count() / queries.size();
+}
+
+
+int main(int argc, char* argv[])
+{
+  size_t numPoints = (argc > 1) ? stoul(argv[1]) : 300000;
+  size_t numQueries = (argc > 2) ? stoul(argv[2]) : 200;
+
+  //
+  // points and queries spread over roughly 50 x 50 miles:
+  //
+  mt19937_64 rng(211);
+  uniform_real_distribution<double> lats(41.5, 42.2);
+  uniform_real_distribution<double> lons(-88.2, -87.5);
+
+  vector<pair<double, double>> points(numPoints);
+  vector<pair<double, double>> queries(numQueries);
+
+  for (pair<double, double>& p : points) {
+    p = make_pair(lats(rng), lons(rng));
+  }
+  for (pair<double, double>& q : queries) {
+    q = make_pair(lats(rng), lons(rng));
+  }
+
+  auto start = chrono::steady_clock::now();
+
+  SpatialIndex index;
+
+  for (size_t i = 0; i < points.size(); i++) {
+    index.add((int) i, points[i].first, points[i].second);
+  }
+
+  index.build();
+
+  auto stop = chrono::steady_clock::now();
+
+  cout << "** nearest point benchmark **" << endl;
+  cout << "points: " << numPoints << ", queries: " << numQueries << endl;
+  cout << "build: " << chrono::duration<double, milli>(stop - start).count() << " ms" << endl;
+  cout << endl;
+
+  //
+  // the answers, so the compiler cannot skip the work and so the
+  // two can be compared:
+  //
+  vector<int> scanAnswers;
+  vector<int> indexAnswers;
+  size_t scanInRadius = 0;
+  size_t indexInRadius = 0;
+  const double radius = 0.5;  // miles
+
+  auto scanNearest = [&](double lat, double lon)
+  {
+    int best = -1;
+    double bestDistance = 0;
+
+    for (size_t i = 0; i < points.size(); i++) {
+      double d = distBetween2Points(lat, lon, points[i].first, points[i].second);
+
+      if (best < 0 || d < bestDistance) {
+        best = (int) i;
+        bestDistance = d;
+      }
+    }
+
+    scanAnswers.push_back(best);
+  };
+
+  auto indexNearest = [&](double lat, double lon)
+  {
+    indexAnswers.push_back(index.nearest(lat, lon, 1)[0].Item);
+  };
+
+  auto indexNearest10 = [&](double lat, double lon)
+  {
+    indexInRadius += index.nearest(lat, lon, 10).size();
+  };
+
+  auto scanRadius = [&](double lat, double lon)
+  {
+    for (size_t i = 0; i < points.size(); i++) {
+      if (distBetween2Points(lat, lon, points[i].first, points[i].second) <= radius) {
+        scanInRadius++;
+      }
+    }
+  };
+
+  auto indexRadius = [&](double lat, double lon)
+  {
+    indexInRadius += index.withinRadius(lat, lon, radius).size();
+  };
+
+  double scan1 = timeQueries(queries, scanNearest);
+  double index1 = timeQueries(queries, indexNearest);
+  double index10 = timeQueries(queries, indexNearest10);
+  indexInRadius -= 10 * numQueries;
+  double scanR = timeQueries(queries, scanRadius);
+  double indexR = timeQueries(queries, indexRadius);
+
+  cout << "linear scan:  " << scan1 << " us/nearest, " << scanR << " us/radius" << endl;
+  cout << "SpatialIndex: " << index1 << " us/nearest, " << index10 << " us/10-nearest, "
+       << indexR << " us/radius" << endl;
+
+  cout << "(answers " << (scanAnswers == indexAnswers ? "agree" : "DIFFER") << ", "
+       << scanInRadius << " vs " << indexInRadius << " within " << radius << " miles)" << endl;
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*parse_bench.cpp*/
+
+/**
+  * @brief benchmark for loading the nodes of a map file.
+  *
+  * Times loading all the nodes of a map file, first with the
+  * sequential streaming reader and then with the parallel chunked
+  * reader at 1, 2, 4, ... threads, to show how node parsing scales
+  * across cores.
+  *
+  * Usage: bench/parse.out [mapfile] [max threads] [repetitions]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#include "nodes.h"
+#include "osm.h"
+
+using namespace std;
+
+
+//
+// runs the given load function reps times, returning the best
+// time in milliseconds and the # of nodes loaded:
+//
+static double timeLoad(int reps, function<bool(Nodes&)> load, int& numNodes)
+{
+  double best = -1;
+
+  for (int r = 0; r < reps; r++)
+  {
+    Nodes nodes;
+
+    auto start = chrono::steady_clock::now();
+
+    if (!load(nodes)) {
+      return -1;
+    }
+
+    auto stop = chrono::steady_clock::now();
+
+    double ms = chrono::duration<double, milli>(stop - start).count();
+
+    if (best < 0 || ms < best) {
+      best = ms;
+    }
+
+    numNodes = nodes.getNumOsmNodes();
+  }
+
+  return best;
+}
+
+
+int main(int argc, char* argv[])
+{
+  string filename = (argc > 1) ? argv[1] : "nu.osm";
+  int maxThreads = (argc > 2) ? stoi(argv[2]) : max(1, (int) thread::hardware_concurrency());
+  int reps = (argc > 3) ? stoi(argv[3]) : 5;
+
+  int numNodes = 0;
+
+  cout << "** node loading benchmark: " << filename << " **" << endl;
+  cout << "cores: " << thread::hardware_concurrency() << endl;
+
+  double sequential = timeLoad(reps, 
+    [&](Nodes& nodes) -> bool
+    {
+      bool success = osmStreamMappedFile(filename, 
+        [&](const OsmElement& elem) { nodes.add(elem); });
+
+      nodes.finishLoading();
+
+      return success;
+    },
+    numNodes
+  );
+
+  if (sequential < 0) {
+    return 0;
+  }
+
+  cout << "sequential: " << sequential << " ms (" << numNodes << " nodes)" << endl;
+
+  for (int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    double ms = timeLoad(reps, 
+      [&](Nodes& nodes) -> bool
+      {
+        nodes.beginChunks(threads);
+
+        bool success = osmParallelStreamMappedFile(filename, threads,
+          [&](int chunk, const OsmElement& elem) { nodes.addToChunk(chunk, elem); },
+          [&](const OsmElement& elem) { });
+
+        nodes.mergeChunks();
+
+        return success;
+      },
+      numNodes
+    );
+
+    cout << "parallel, " << threads << " thread(s): " << ms << " ms"
+         << " (speedup " << sequential / ms << "x, " << numNodes << " nodes)" << endl;
+  }
+
+  return 0;
+}
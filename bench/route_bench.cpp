@@ -0,0 +1,241 @@
+/*route_bench.cpp*/
+
+/**
+  * @brief benchmark for point-to-point walking queries.
+  *
+  * Loads the map and its walking graph, picks random (building,
+  * amenity) pairs, and finds the walking distance between the
+  * vertices where each joins the graph with plain Dijkstra, A*,
+  * bidirectional A* and the contraction hierarchy. Reports the
+  * average # of vertices settled and the time per query for each,
+  * and checks they all find the same distances.
+  *
+  * Then finds the walking distance of each pair from the building's
+  * entrances with Amenities::findWalkingDistance, without and with
+  * the hierarchy, and checks it against Dijkstra (shortestDistance)
+  * from each entrance.
+  *
+  * Usage: bench/route.out [# of pairs]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "osm.h"
+#include "snapshot.h"
+
+using namespace std;
+
+
+int main(int argc, char* argv[])
+{
+  size_t numPairs = (argc > 1) ? stoul(argv[1]) : 5000;
+
+  string filename = "nu.osm";
+
+  Nodes nodes;
+  Buildings buildings;
+  Amenities amenities;
+  Graph graph;
+  ContractionHierarchy hierarchy;
+
+  if (!snapshotLoad(filename + ".snap", filename, nodes, buildings, amenities, graph, hierarchy))
+  {
+    bool success = osmStreamMappedFile(filename,
+      [&](const OsmElement& elem)
+      {
+        nodes.add(elem);
+        buildings.add(elem);
+        amenities.add(elem);
+        graph.add(elem);
+      });
+
+    if (!success) {
+      return 0;
+    }
+
+    nodes.finishLoading();
+    buildings.finishLoading(nodes);
+    amenities.finishLoading(nodes);
+    graph.finishLoading(nodes);
+    hierarchy.build(graph);
+  }
+
+  //
+  // the buildings and amenities that join the graph, and the
+  // vertices where they do:
+  //
+  vector<int> fromBuildings, toAmenities;
+  vector<uint32_t> from, to;
+  vector<double> toDistances;
+
+  for (size_t b = 0; b < buildings.osmBuildings.size(); b++)
+  {
+    pair<double, double> location = buildings.osmBuildings[b].getLocation();
+    double distance;
+    int vertex = graph.nearestVertex(location.first, location.second, distance);
+
+    if (vertex >= 0) {
+      fromBuildings.push_back((int) b);
+      from.push_back((uint32_t) vertex);
+    }
+  }
+
+  for (size_t a = 0; a < amenities.osmAmenities.size(); a++)
+  {
+    pair<double, double> location = amenities.osmAmenities[a].getLocation();
+    double distance;
+    int vertex = graph.nearestVertex(location.first, location.second, distance);
+
+    if (vertex >= 0) {
+      toAmenities.push_back((int) a);
+      to.push_back((uint32_t) vertex);
+      toDistances.push_back((float) distance);  // as Amenities keeps it
+    }
+  }
+
+  if (from.empty() || to.empty()) {
+    cout << "**ERROR: no walking graph" << endl;
+    return 0;
+  }
+
+  mt19937_64 rng(211);
+  uniform_int_distribution<size_t> pickFrom(0, from.size() - 1);
+  uniform_int_distribution<size_t> pickTo(0, to.size() - 1);
+  vector<pair<size_t, size_t>> picks;  // positions in from / to
+  vector<pair<uint32_t, uint32_t>> pairs;
+
+  for (size_t i = 0; i < numPairs; i++)
+  {
+    picks.push_back(make_pair(pickFrom(rng), pickTo(rng)));
+    pairs.push_back(make_pair(from[picks[i].first], to[picks[i].second]));
+  }
+
+  cout << "** point-to-point walking benchmark: " << filename << " **" << endl;
+  cout << "graph: " << graph.getNumEdges() << " edges, pairs: " << numPairs << endl;
+  cout << endl;
+
+  GraphSearch forward, backward;
+  vector<double> answers[4];
+  const char* NAMES[4] = { "dijkstra:         ", "A*:               ", "bidirectional A*: ", "hierarchy:        " };
+
+  for (int algorithm = 0; algorithm < 4; algorithm++)
+  {
+    size_t settled = 0;
+
+    auto start = chrono::steady_clock::now();
+
+    for (pair<uint32_t, uint32_t> p : pairs)
+    {
+      double distance;
+
+      if (algorithm == 0) {
+        distance = shortestDistance(graph, p.first, p.second, forward);
+      }
+      else if (algorithm == 1) {
+        distance = shortestDistanceAStar(graph, p.first, p.second, forward);
+      }
+      else if (algorithm == 2) {
+        distance = shortestDistanceBidirectional(graph, p.first, p.second, forward, backward);
+        settled += backward.getNumSettled();
+      }
+      else {
+        pair<uint32_t, double> source[1] = { make_pair(p.first, 0.0) };
+        pair<uint32_t, double> target[1] = { make_pair(p.second, 0.0) };
+
+        distance = hierarchy.findDistance(source, target, forward, backward);
+        settled += backward.getNumSettled();
+      }
+
+      settled += forward.getNumSettled();
+      answers[algorithm].push_back(distance);
+    }
+
+    auto stop = chrono::steady_clock::now();
+
+    size_t same = 0;
+
+    for (size_t i = 0; i < numPairs; i++) {
+      //
+      // shortcut lengths are rounded to float, so the hierarchy's
+      // distances can be off in the 7th digit:
+      //
+      same += (fabs(answers[algorithm][i] - answers[0][i]) <= 1e-6 * max(1.0, answers[0][i])) ? 1 : 0;
+    }
+
+    cout << NAMES[algorithm] << (double) settled / numPairs << " settled/query, "
+         << chrono::duration<double, micro>(stop - start).count() / numPairs << " us/query"
+         << (same == numPairs ? "" : " (DIFFERENT distances)") << endl;
+  }
+
+  //
+  // building (from its entrances) to amenity, through Amenities;
+  // Dijkstra from each entrance gives the expected distance:
+  //
+  vector<vector<pair<uint32_t, double>>> sources(from.size());
+  vector<double> expected;
+
+  for (size_t b = 0; b < from.size(); b++) {
+    sources[b] = buildings.getWalkingSources(fromBuildings[b], nodes, graph);
+  }
+
+  for (pair<size_t, size_t> pick : picks)
+  {
+    double best = numeric_limits<double>::infinity();
+
+    for (pair<uint32_t, double> source : sources[pick.first]) {
+      best = min(best, source.second + shortestDistance(graph, source.first, to[pick.second], forward));
+    }
+
+    expected.push_back(best + toDistances[pick.second]);
+  }
+
+  amenities.setGraph(graph);
+
+  const char* AMENITY_NAMES[2] = { "amenities, A*:        ", "amenities, hierarchy: " };
+
+  for (int algorithm = 0; algorithm < 2; algorithm++)
+  {
+    if (algorithm == 1) {
+      amenities.setHierarchy(hierarchy);
+    }
+
+    size_t same = 0;
+
+    auto start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < numPairs; i++)
+    {
+      float distance = amenities.findWalkingDistance(sources[picks[i].first], toAmenities[picks[i].second]);
+      double want = isinf(expected[i]) ? -1 : expected[i];
+
+      //
+      // the answer is a float, and shortcut lengths are rounded to
+      // float, so allow for both:
+      //
+      same += (fabs(distance - want) <= 1e-6 * max(1.0, want)) ? 1 : 0;
+    }
+
+    auto stop = chrono::steady_clock::now();
+
+    cout << AMENITY_NAMES[algorithm]
+         << chrono::duration<double, micro>(stop - start).count() / numPairs << " us/query"
+         << (same == numPairs ? "" : " (DIFFERENT distances)") << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+/*search_bench.cpp*/
+
+/**
+  * @brief benchmark for searching buildings by name.
+  *
+  * Fills Buildings with random multi-word names, from about the
+  * size of the campus map up to tens of thousands of buildings,
+  * and compares Buildings::findByName (trigram index) against
+  * lowercasing and searching every name, as the b command used
+  * to. The answers of the two are checked against each other.
+  *
+  * Usage: bench/search.out [# of queries]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include "buildings.h"
+#include "nodes.h"
+
+using namespace std;
+
+
+static const vector<string> WORDS = {
+  "hall", "library", "center", "science", "engineering", "music",
+  "annex", "tech", "research", "student", "memorial", "north",
+  "south", "west", "east", "lab", "arts", "house", "garage", "chapel",
+  "kellogg", "mudd", "ford", "allen", "norris", "pick", "deering",
+};
+
+static string lowercase(string_view sv)
+{
+  string s(sv);
+
+  for (char& c : s) c = tolower(c);
+
+  return s;
+}
+
+
+int main(int argc, char* argv[])
+{
+  size_t numQueries = (argc > 1) ? stoul(argv[1]) : 200;
+
+  const vector<string> QUERIES = { "mudd", "science hall", "Tech", "ll", "norris annex", "zzz" };
+
+  cout << "** building name search benchmark **" << endl;
+  cout << "queries: " << numQueries << endl;
+  cout << endl;
+
+  for (size_t numBuildings : { 100, 1000, 10000, 50000 })
+  {
+    mt19937_64 rng(211);
+    uniform_int_distribution<size_t> words(0, WORDS.size() - 1);
+    uniform_int_distribution<int> lengths(1, 4);
+
+    Nodes nodes;
+    Buildings buildings;
+    OsmElement elem;
+
+    nodes.finishLoading();
+
+    for (size_t b = 0; b < numBuildings; b++)
+    {
+      string name;
+
+      for (int w = lengths(rng); w > 0; w--) {
+        name += (name.empty() ? "" : " ") + WORDS[words(rng)];
+      }
+
+      name[0] = toupper(name[0]);
+      name += " " + to_string(b);
+
+      elem.clear();
+      elem.ElemKind = OsmElement::WAY;
+      elem.ID = (long long) b + 1;
+      elem.addTag("building", "university");
+      elem.addTag("name", name);
+
+      buildings.add(elem);
+    }
+
+    buildings.finishLoading(nodes);
+
+    //
+    // the old way, every name lowercased on every query:
+    //
+    size_t same = 0;
+
+    auto start = chrono::steady_clock::now();
+
+    for (size_t q = 0; q < numQueries; q++)
+    {
+      string text = lowercase(QUERIES[q % QUERIES.size()]);
+      vector<int> matches;
+
+      for (size_t i = 0; i < buildings.osmBuildings.size(); i++) {
+        if (lowercase(buildings.osmBuildings[i].getName()).find(text) != string::npos) {
+          matches.push_back((int) i);
+        }
+      }
+
+      same += (matches == buildings.findByName(QUERIES[q % QUERIES.size()])) ? 1 : 0;
+    }
+
+    auto middle = chrono::steady_clock::now();
+
+    size_t numMatches = 0;
+
+    for (size_t q = 0; q < numQueries; q++) {
+      numMatches += buildings.findByName(QUERIES[q % QUERIES.size()]).size();
+    }
+
+    auto stop = chrono::steady_clock::now();
+
+    //
+    // the scan time includes one indexed search per query, to
+    // check the answers; take it out:
+    //
+    double indexed = chrono::duration<double, micro>(stop - middle).count() / numQueries;
+    double scan = chrono::duration<double, micro>(middle - start).count() / numQueries - indexed;
+
+    cout << numBuildings << " buildings: scan " << scan << " us/query, index "
+         << indexed << " us/query (" << numMatches / numQueries << " matches/query, "
+         << (same == numQueries ? "same" : "DIFFERENT") << " answers)" << endl;
+  }
+
+  return 0;
+}
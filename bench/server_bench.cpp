@@ -0,0 +1,234 @@
+/*server_bench.cpp*/
+
+/**
+  * @brief benchmark for the HTTP query server.
+  *
+  * Loads the map, starts a QueryServer on a loopback port in a
+  * background thread, and then drives it from a number of client
+  * connections, each keeping a window of requests in flight
+  * (pipelined on one keep-alive connection). Reports requests per
+  * second and the time to handle( ) one request without the
+  * network, for a building lookup, an amenity lookup and a
+  * nearest fast food query (by straight-line and by walking
+  * distance).
+  *
+  * Usage: bench/server.out [# of connections] [# of requests per
+  *        connection] [pipeline depth]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "osm.h"
+#include "snapshot.h"
+#include "server.h"
+
+using namespace std;
+
+
+static const int PORT = 18211;
+
+static const vector<string> TARGETS = {
+  "/buildings?name=mudd",
+  "/amenities?type=cafe",
+  "/fast-food/nearest?building=tech",
+  "/fast-food/nearest?building=tech&mode=walk",
+};
+
+
+//
+// sends numRequests requests on one connection, at most depth at a
+// time, and reads the responses; returns false on any error:
+//
+static bool runClient(int numRequests, int depth)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  sockaddr_in addr = {};
+
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(PORT);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+  if (fd < 0 || connect(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+    if (fd >= 0) close(fd);
+    return false;
+  }
+
+  int sent = 0, received = 0;
+  string in;
+  char buffer[64 * 1024];
+
+  while (received < numRequests)
+  {
+    //
+    // top up the window of requests in flight:
+    //
+    string out;
+
+    while (sent < numRequests && sent - received < depth) {
+      out += "GET " + TARGETS[sent % TARGETS.size()] + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+      sent++;
+    }
+
+    if (!out.empty() && send(fd, out.data(), out.size(), MSG_NOSIGNAL) != (ssize_t) out.size()) {
+      break;
+    }
+
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+
+    if (n <= 0) {
+      break;
+    }
+
+    in.append(buffer, n);
+
+    //
+    // count the complete responses, using their Content-Length:
+    //
+    while (true)
+    {
+      size_t headerEnd = in.find("\r\n\r\n");
+
+      if (headerEnd == string::npos) {
+        break;
+      }
+
+      size_t length = in.find("Content-Length: ");
+      size_t bodySize = stoul(in.substr(length + 16));
+
+      if (in.size() < headerEnd + 4 + bodySize) {
+        break;
+      }
+
+      in.erase(0, headerEnd + 4 + bodySize);
+      received++;
+    }
+  }
+
+  close(fd);
+
+  return received == numRequests;
+}
+
+
+int main(int argc, char* argv[])
+{
+  int numClients = (argc > 1) ? stoi(argv[1]) : 8;
+  int numRequests = (argc > 2) ? stoi(argv[2]) : 5000;
+  int depth = (argc > 3) ? stoi(argv[3]) : 16;
+
+  string filename = "nu.osm";
+
+  Nodes nodes;
+  Buildings buildings;
+  Amenities amenities;
+  Graph graph;
+  ContractionHierarchy hierarchy;
+
+  if (!snapshotLoad(filename + ".snap", filename, nodes, buildings, amenities, graph, hierarchy))
+  {
+    bool success = osmStreamMappedFile(filename,
+      [&](const OsmElement& elem)
+      {
+        nodes.add(elem);
+        buildings.add(elem);
+        amenities.add(elem);
+        graph.add(elem);
+      });
+
+    if (!success) {
+      return 0;
+    }
+
+    nodes.finishLoading();
+    buildings.finishLoading(nodes);
+    amenities.finishLoading(nodes);
+    graph.finishLoading(nodes);
+    hierarchy.build(graph);
+  }
+
+  amenities.setGraph(graph);
+  amenities.setHierarchy(hierarchy);
+
+  QueryServer server(nodes, buildings, amenities);
+
+  if (!server.listen(to_string(PORT))) {
+    return 0;
+  }
+
+  cout << "** HTTP server benchmark **" << endl;
+  cout << "connections: " << numClients << ", requests each: " << numRequests
+       << ", pipeline depth: " << depth << endl;
+  cout << endl;
+
+  //
+  // handle( ) alone, without the network:
+  //
+  for (const string& target : TARGETS)
+  {
+    const int REPS = 2000;
+    string body;
+
+    auto start = chrono::steady_clock::now();
+
+    for (int r = 0; r < REPS; r++) {
+      server.handle("GET", target, body);
+    }
+
+    auto stop = chrono::steady_clock::now();
+
+    cout << "handle " << target << ": "
+         << chrono::duration<double, micro>(stop - start).count() / REPS << " us/request" << endl;
+  }
+
+  //
+  // over loopback, all the clients at once:
+  //
+  thread serverThread(&QueryServer::run, &server);
+
+  vector<thread> clients;
+  vector<char> ok(numClients, 0);
+
+  auto start = chrono::steady_clock::now();
+
+  for (int c = 0; c < numClients; c++) {
+    clients.push_back(thread([&, c]() { ok[c] = runClient(numRequests, depth); }));
+  }
+
+  for (thread& client : clients) {
+    client.join();
+  }
+
+  auto stop = chrono::steady_clock::now();
+
+  server.stop();
+  serverThread.join();
+
+  double seconds = chrono::duration<double>(stop - start).count();
+  int failed = (int) count(ok.begin(), ok.end(), 0);
+
+  cout << endl;
+  cout << "total: " << (long long) numClients * numRequests << " requests in " << seconds * 1000 << " ms, "
+       << (long long) (numClients * (double) numRequests / seconds) << " requests/sec"
+       << (failed > 0 ? " (" + to_string(failed) + " connections FAILED)" : "") << endl;
+
+  return 0;
+}
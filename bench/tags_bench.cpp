@@ -0,0 +1,154 @@
+/*tags_bench.cpp*/
+
+/**
+  * @brief benchmark for looking up the tags of map elements.
+  *
+  * Reads the elements of the map, and for each one does the tag
+  * lookups loading needs (is it an entrance, a university
+  * building, an amenity; its name and address) two ways:
+  *
+  *   - the way loading used to: tags stored as pairs of strings,
+  *     a separate scan per key, keys passed as const string& and
+  *     values returned as string copies
+  *   - with the string_view API: osmGetKeyValue for the entrance,
+  *     and osmGetKeyValues for the rest, one scan per element
+  *
+  * Reports the time per element, and checks both find the same
+  * values.
+  *
+  * Usage: bench/tags.out [map file] [# of repetitions]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "osm.h"
+
+using namespace std;
+
+
+//
+// the old representation and lookups, for comparison:
+//
+typedef vector<pair<string, string>> OldTags;
+
+static bool oldContainsKeyValue(const OldTags& tags, const string& key, const string& value)
+{
+  for (const pair<string, string>& tag : tags) {
+    if (tag.first == key && tag.second == value) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static string oldGetKeyValue(const OldTags& tags, const string& key)
+{
+  for (const pair<string, string>& tag : tags) {
+    if (tag.first == key) {
+      return tag.second;
+    }
+  }
+
+  return "";
+}
+
+
+int main(int argc, char* argv[])
+{
+  string filename = (argc > 1) ? argv[1] : "nu.osm";
+  int reps = (argc > 2) ? stoi(argv[2]) : 20;
+
+  vector<OsmElement> elements;
+  vector<OldTags> oldElements;
+
+  bool success = osmStreamMappedFile(filename,
+    [&](const OsmElement& elem)
+    {
+      elements.push_back(elem);
+      oldElements.push_back(OldTags());
+
+      for (size_t i = 0; i < elem.getNumTags(); i++) {
+        oldElements.back().emplace_back(elem.getTagKey(i), elem.getTagValue(i));
+      }
+    });
+
+  if (!success) {
+    return 0;
+  }
+
+  size_t n = elements.size();
+  size_t checksumOld = 0, checksumNew = 0;
+
+  //
+  // the old way:
+  //
+  auto start = chrono::steady_clock::now();
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (const OldTags& tags : oldElements)
+    {
+      bool entrance = oldContainsKeyValue(tags, "entrance", "yes") ||
+        oldContainsKeyValue(tags, "entrance", "main") ||
+        oldContainsKeyValue(tags, "entrance", "entrance");
+
+      bool building = oldContainsKeyValue(tags, "building", "university");
+      string amenity = oldGetKeyValue(tags, "amenity");
+      string name = oldGetKeyValue(tags, "name");
+      string address = oldGetKeyValue(tags, "addr:housenumber") + " " + oldGetKeyValue(tags, "addr:street");
+
+      checksumOld += entrance + building + amenity.size() + name.size() + address.size();
+    }
+  }
+
+  auto middle = chrono::steady_clock::now();
+
+  //
+  // the string_view way:
+  //
+  static const string_view KEYS[] = { "building", "amenity", "name", "addr:housenumber", "addr:street" };
+  string_view values[5];
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (const OsmElement& elem : elements)
+    {
+      string_view entrance = osmGetKeyValue(elem, "entrance");
+      bool isEntrance = (entrance == "yes" || entrance == "main" || entrance == "entrance");
+
+      osmGetKeyValues(elem, KEYS, values);
+
+      bool building = (values[0] == "university");
+
+      checksumNew += isEntrance + building + values[1].size() + values[2].size()
+        + values[3].size() + 1 + values[4].size();
+    }
+  }
+
+  auto stop = chrono::steady_clock::now();
+
+  double oldTime = chrono::duration<double, nano>(middle - start).count() / (n * reps);
+  double newTime = chrono::duration<double, nano>(stop - middle).count() / (n * reps);
+
+  size_t numTagged = 0;
+
+  for (const OsmElement& elem : elements) {
+    numTagged += (elem.getNumTags() > 0) ? 1 : 0;
+  }
+
+  cout << "** tag lookup benchmark: " << filename << " **" << endl;
+  cout << "elements: " << n << " (" << numTagged << " with tags), repetitions: " << reps << endl;
+  cout << endl;
+  cout << "string copies, a scan per key: " << oldTime << " ns/element" << endl;
+  cout << "string_view, one scan:         " << newTime << " ns/element"
+       << (checksumOld == checksumNew ? " (same values)" : " (DIFFERENT)") << endl;
+
+  return 0;
+}
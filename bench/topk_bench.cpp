@@ -0,0 +1,214 @@
+/*topk_bench.cpp*/
+
+/**
+  * @brief benchmark for the k nearest amenities by walking distance.
+  *
+  * Loads the map and its walking graph, and from the entrances of
+  * every building finds the k nearest amenities of a few types
+  * (cafe, fast_food, restaurant): with a Dijkstra search of the
+  * whole graph, then picking the k nearest, and with
+  * Amenities::findNearestWalking, which stops once the k nearest are
+  * certain, without and then with the contraction hierarchy (one
+  * upward search per type). Reports the time per building for
+  * each, the average # of vertices settled by the single searches,
+  * and checks they all find the same amenities.
+  *
+  * Usage: bench/topk.out [k] [# of repetitions]
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+#include "graph.h"
+#include "hierarchy.h"
+#include "osm.h"
+#include "snapshot.h"
+
+using namespace std;
+
+
+int main(int argc, char* argv[])
+{
+  size_t k = (argc > 1) ? stoul(argv[1]) : 5;
+  int reps = (argc > 2) ? stoi(argv[2]) : 20;
+
+  string filename = "nu.osm";
+
+  Nodes nodes;
+  Buildings buildings;
+  Amenities amenities;
+  Graph graph;
+  ContractionHierarchy hierarchy;
+
+  if (!snapshotLoad(filename + ".snap", filename, nodes, buildings, amenities, graph, hierarchy))
+  {
+    bool success = osmStreamMappedFile(filename,
+      [&](const OsmElement& elem)
+      {
+        nodes.add(elem);
+        buildings.add(elem);
+        amenities.add(elem);
+        graph.add(elem);
+      });
+
+    if (!success) {
+      return 0;
+    }
+
+    nodes.finishLoading();
+    buildings.finishLoading(nodes);
+    amenities.finishLoading(nodes);
+    graph.finishLoading(nodes);
+    hierarchy.build(graph);
+  }
+
+  amenities.setGraph(graph);
+
+  vector<int> typeIDs;
+  vector<pair<uint32_t, double>> targets;  // (vertex, distance from there), by position
+
+  for (const char* type : { "cafe", "fast_food", "restaurant" }) {
+    typeIDs.push_back(amenities.getTypeID(type));
+  }
+
+  for (const Amenity& A : amenities.osmAmenities)
+  {
+    pair<double, double> location = A.getLocation();
+    double distance;
+    int vertex = graph.nearestVertex(location.first, location.second, distance);
+
+    targets.push_back(make_pair((uint32_t) max(vertex, 0), distance));
+  }
+
+  vector<vector<pair<uint32_t, double>>> sources;
+
+  for (size_t b = 0; b < buildings.osmBuildings.size(); b++) {
+    sources.push_back(buildings.getWalkingSources((int) b, nodes, graph));
+  }
+
+  cout << "** k nearest by walking benchmark: " << filename << " **" << endl;
+  cout << "graph: " << graph.getNumEdges() << " edges, buildings: " << sources.size()
+       << ", k: " << k << endl;
+  cout << endl;
+
+  //
+  // Dijkstra over the whole graph, then the k nearest:
+  //
+  GraphSearch search;
+  vector<vector<int>> expected(sources.size());
+  size_t settled = 0;
+
+  auto start = chrono::steady_clock::now();
+
+  for (int r = 0; r < reps; r++)
+  {
+    for (size_t b = 0; b < sources.size(); b++)
+    {
+      uint32_t vertex;
+      double distance;
+
+      search.start(graph);
+
+      for (pair<uint32_t, double> source : sources[b]) {
+        search.addSource(source.first, source.second);
+      }
+
+      while (search.next(vertex, distance)) { }
+
+      settled += search.getNumSettled();
+
+      vector<pair<double, int>> found;
+
+      for (size_t i = 0; i < amenities.osmAmenities.size(); i++)
+      {
+        int typeID = amenities.osmAmenities[i].getTypeID();
+        double walked = search.getDistance(targets[i].first);
+
+        if (find(typeIDs.begin(), typeIDs.end(), typeID) != typeIDs.end() && !isinf(walked)) {
+          found.push_back(make_pair(walked + targets[i].second, (int) i));
+        }
+      }
+
+      size_t n = min(k, found.size());
+
+      partial_sort(found.begin(), found.begin() + n, found.end());
+
+      expected[b].clear();
+
+      for (size_t i = 0; i < n; i++) {
+        expected[b].push_back(found[i].second);
+      }
+    }
+  }
+
+  auto stop = chrono::steady_clock::now();
+
+  size_t numQueries = reps * sources.size();
+
+  cout << "full search: " << (double) settled / numQueries << " settled/building, "
+       << chrono::duration<double, micro>(stop - start).count() / numQueries << " us/building" << endl;
+
+  //
+  // one search that stops at the k-th nearest, then one upward
+  // search of the hierarchy per type:
+  //
+  const char* NAMES[2] = { "k nearest:   ", "hierarchy:   " };
+
+  for (int algorithm = 0; algorithm < 2; algorithm++)
+  {
+    if (algorithm == 1) {
+      amenities.setHierarchy(hierarchy);
+    }
+
+    size_t same = 0;
+
+    settled = 0;
+
+    start = chrono::steady_clock::now();
+
+    for (int r = 0; r < reps; r++)
+    {
+      for (size_t b = 0; b < sources.size(); b++)
+      {
+        vector<pair<int, float>> nearest = amenities.findNearestWalking(sources[b], typeIDs, k);
+
+        settled += GraphSearch::forThisThread().getNumSettled();
+
+        if (r == 0)
+        {
+          bool ok = (nearest.size() == expected[b].size());
+
+          for (size_t i = 0; ok && i < nearest.size(); i++) {
+            ok = (nearest[i].first == expected[b][i]);
+          }
+
+          same += ok ? 1 : 0;
+        }
+      }
+    }
+
+    stop = chrono::steady_clock::now();
+
+    if (algorithm == 0) {  // the hierarchy runs a search per type
+      cout << NAMES[algorithm] << (double) settled / numQueries << " settled/building, ";
+    }
+    else {
+      cout << NAMES[algorithm];
+    }
+
+    cout << chrono::duration<double, micro>(stop - start).count() / numQueries << " us/building"
+         << (same == sources.size() ? "" : " (DIFFERENT amenities)") << endl;
+  }
+
+  return 0;
+}
@@ -24,58 +24,72 @@ using namespace std;
 //
 // constructor
 //
-Building::Building(long long id, string name, string streetAddr)
-  : ID(id), Name(name), StreetAddress(streetAddr)
+Building::Building(long long id, string_view name, string_view streetAddr, span<const uint32_t> nodeIndices)
+  : ID(id), Name(name), StreetAddress(streetAddr), NodeIndices(nodeIndices),
+    Location(0, 0), Bounds{0, 0, 0, 0}
 {
-  // vector is default initialized by its constructor
 }
 
 
 //
-// adds the given nodeid to the end of the vector.
+// sets the indices (in the node table) of the nodes that define
+// the position / outline.
 //
-void Building::add(long long nodeid)
+void Building::setNodeIndices(span<const uint32_t> nodeIndices)
 {
-  this->NodeIDs.push_back(nodeid);
+  this->NodeIndices = nodeIndices;
 }
 
 
 //
-// prints information about this building to the console
+// computes the location (the average of the nodes' positions) and
+// the bounding box, so the queries don't have to visit the nodes.
 //
-void Building::print()  // summary
+void Building::setGeometry(const NodeTable& table)
+{
+  this->Location = table.getCentroid(this->NodeIndices);
+  this->Bounds = table.getBounds(this->NodeIndices);
+}
+
+
+//
+// prints information about this building to the console (or the
+// given stream)
+//
+void Building::print(ostream& out) const  // summary
 {
   //
   // print a simple one line summary of building:
   //
-  cout << this->Name << ": "
+  out << this->Name << ": "
        << this->StreetAddress
-       << endl;
+       << '\n';
        
   return;
 }
 
-void Building::print(Nodes &nodes)  // detailed
+void Building::print(const Nodes& nodes, ostream& out) const  // detailed
 {
   //
   // print a more complete, detailed output of building:
   //
-  cout << this->Name << endl;
-  cout << " OSM ID: " << this->ID << endl;
-  cout << " Address: " << this->StreetAddress << endl;
+  out << this->Name << '\n';
+  out << " OSM ID: " << this->ID << '\n';
+  out << " Address: " << this->StreetAddress << '\n';
   
   // implement getLocation() function, call here, and output
   // returned latitude and longitude:
 
-  pair<double, double> avg_location = getLocation(nodes);
-  cout << " GPS Location: " << avg_location.first << ", " << avg_location.second << endl;
+  pair<double, double> avg_location = getLocation();
+  out << " GPS Location: " << avg_location.first << ", " << avg_location.second << '\n';
 
  
-  // loop through the sorted nodeids, and for each id, call
-  // the find( ) function in the Nodes class to obtain
+  // loop through the nodes in order of id, and output their
   // latitude, longitude, and whether it's an entrance or not.
-  //
-  // If the find( ) function returns false, output "**NODE NOT FOUND**"
+  // The node indices were resolved when the map was loaded (and
+  // nodes that are not in the map were dropped), so this reads 
+  // straight from the node table. The table is sorted by id, so
+  // sorting the indices sorts by id.
   //
   // output format:
   //   id: (latitude, longitude)
@@ -84,22 +98,24 @@ void Building::print(Nodes &nodes)  // detailed
   // where each line has 2 leading spaces
   //
 
-  cout << " Nodes:" << endl;
+  out << " Nodes:" << '\n';
     
-  vector<long long> sorted = this->getNodeIDs();
-
-  for (long long id : sorted){
-    double lat = 0;
-    double lon = 0;
-    bool isEntrance = false;
-    bool check = nodes.find(id, lat, lon, isEntrance);
-    if (check){  
-      if (isEntrance){
-          cout << "  " << id << ": " << "(" << lat << ", " << lon << "), is entrance" << endl;
-      }
-      else {   
-        cout << "  " << id << ": " << "(" << lat << ", " << lon << ")" << endl;
-      }
+  NodeTable table = nodes.getTable();
+
+  vector<uint32_t> sorted(this->NodeIndices.begin(), this->NodeIndices.end());
+
+  std::sort(sorted.begin(), sorted.end());
+
+  for (uint32_t i : sorted){
+    long long id = table.IDs[i];
+    double lat = table.getLat(i);
+    double lon = table.getLon(i);
+
+    if (table.getIsEntrance(i)){
+      out << "  " << id << ": " << "(" << lat << ", " << lon << "), is entrance" << '\n';
+    }
+    else {   
+      out << "  " << id << ": " << "(" << lat << ", " << lon << ")" << '\n';
     }
   }
    
@@ -110,47 +126,40 @@ void Building::print(Nodes &nodes)  // detailed
 //
 // getters:
 //
-long long Building::getID() 
+long long Building::getID() const
 { return this->ID; }
 
-string Building::getName()
+string_view Building::getName() const
 { return this->Name; }
 
-string Building::getStreetAddress()
+string_view Building::getStreetAddress() const
 { return this->StreetAddress; }
 
+// returns the node indices in their original order, without copying
+span<const uint32_t> Building::getNodeIndices() const
+{ return this->NodeIndices; }
+
 // returns a sorted copy of the node ids
-vector<long long> Building::getNodeIDs()
+vector<long long> Building::getNodeIDs(const Nodes& nodes) const
 { 
-  vector<long long> copy = this->NodeIDs;
+  NodeTable table = nodes.getTable();
+
+  vector<long long> copy;
+  
+  for (uint32_t i : this->NodeIndices) {
+    copy.push_back(table.IDs[i]);
+  }
   
   std::sort(copy.begin(), copy.end());
   
   return copy;
 }
 
-pair<double, double> Building::getLocation(Nodes &nodes)
-{
-
-    double lat_total = 0;
-    double lon_total = 0;
-    double length = 0;
-  
-  for (long long id : NodeIDs){
-    double lat = 0;
-    double lon = 0;
-    bool isEntrance = false;
-    bool check = nodes.find(id, lat, lon, isEntrance);
-    if (check){  
-      lat_total += lat;
-      lon_total += lon;
-      length += 1;
-    }
-  }
+// returns the location computed by setGeometry, the average of
+// the nodes' positions
+pair<double, double> Building::getLocation() const
+{ return this->Location; }
 
-  double avg_lat = lat_total / length;
-  double avg_lon = lon_total / length;
-
-  return make_pair(avg_lat, avg_lon);
-
-}
+// returns the bounding box computed by setGeometry
+BoundingBox Building::getBounds() const
+{ return this->Bounds; }
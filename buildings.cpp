@@ -12,6 +12,8 @@
 #include <vector>
 #include <cassert>
 #include <algorithm>
+#include <iterator>
+#include <functional>
 
 #include "buildings.h"
 #include "osm.h"
@@ -27,13 +29,46 @@ using namespace tinyxml2;
   * @return s, the lowercase string
   */
 
-string toLowerBuildings(string s)
+string toLowerBuildings(string_view sv)
 {
+  string s(sv);
+
   for (char& c : s) c = tolower(c);
 
   return s;
 }
 
+//
+// the 3 chars of s starting at i, packed into an int:
+//
+static uint32_t trigramOf(string_view s, size_t i)
+{
+  return ((uint32_t) (unsigned char) s[i] << 16) 
+    | ((uint32_t) (unsigned char) s[i + 1] << 8) 
+    | (uint32_t) (unsigned char) s[i + 2];
+}
+
+
+/**
+  * @brief default constructor, creates an empty collection.
+  */
+Buildings::Buildings()
+  : Buildings(make_shared<StringPool>())
+{
+  // vector is default initialized by its constructor
+}
+
+
+/**
+  * @brief creates an empty collection that keeps its text, and its
+  * indexes, in the given pool.
+  */
+Buildings::Buildings(shared_ptr<StringPool> strings)
+  : Strings(strings), NodeIndices(strings->getArena()), NumMissingNodes(0),
+    LowerNames(strings->getArena()), NameTrigrams(strings->getArena())
+{
+}
+
 
 /**
   * @brief constructor to retrieve all the buildings from the open street map.
@@ -42,103 +77,179 @@ string toLowerBuildings(string s)
   * stores all the buildings into the vector data member.
   * 
   * @param xmldoc An XML document object denoting the open street map.
+  * @param nodes The nodes of the map, already loaded.
   * @return nothing.
   */
-Buildings::Buildings(XMLDocument& xmldoc)
+Buildings::Buildings(XMLDocument& xmldoc, Nodes& nodes)
+  : Buildings(make_shared<StringPool>())
 {
   XMLElement* osm = xmldoc.FirstChildElement("osm");
   assert(osm != nullptr);
 
   //
   // Parse the XML document element by element, 
-  // looking for amenities:
+  // looking for buildings:
   //
   XMLElement* element = osm->FirstChildElement();
+  OsmElement elem;
 
   while (element != nullptr)
   {
     string tag = element->Value();
     
-    if (tag != "node" && tag != "way") {
-      element = element->NextSiblingElement();
-      continue;
+    if (tag == "node" || tag == "way") {
+      osmReadElement(element, elem);
+      this->add(elem);
     }
-    
-    const XMLAttribute* attr = element->FindAttribute("id");
-    assert(attr != nullptr);
-    
+
+    element = element->NextSiblingElement();
+  }//while
+
+  this->finishLoading(nodes);
+}
+
+
+/**
+  * @brief stores the given element if it's a named university building.
+  *
+  * @param elem A node or way from the open street map.
+  * @return nothing.
+  */
+void Buildings::add(const OsmElement& elem)
+{
+  if (elem.ElemKind == OsmElement::RELATION) {
+    return;
+  }
+
+  //
+  // the tags we need, found in one pass over the element's tags
+  // (the values are views into elem, nothing is copied yet):
+  //
+  static const string_view KEYS[] = { "building", "name", "addr:housenumber", "addr:street" };
+  string_view values[4];
+
+  osmGetKeyValues(elem, KEYS, values);
+
+  //
+  // if this is a building, store info into vector:
+  //
+  if (values[0] != "university") {
+    return;
+  }
+
+  string_view name = values[1];
+  
+  if (name == "") { // no name, ignore!
+    return;
+  }
+
+  string streetAddr(values[2]);
+
+  streetAddr += " ";
+  streetAddr += values[3];
+
+  string_view nameView = this->Strings->intern(name);
+
+  string_view streetAddrView = this->Strings->intern(streetAddr);
+
+  //
+  // remember the associated node ids, which are resolved to
+  // indices in the node table by finishLoading( ):
+  //
+  size_t offset = this->PendingNodeIDs.size();
+
+  if (elem.ElemKind == OsmElement::NODE) {
+    //
+    // this node defines the position of the building, so
+    // it's our only node reference:
+    //
+    this->PendingNodeIDs.push_back(elem.ID);
+  }
+  else {
     //
-    // if this is a building, store info into vector:
+    // the way has a list of nodes that define the perimeter,
+    // so collect the node ids as references to the perimeter
+    // nodes:
     //
-    if (osmContainsKeyValue(element, "building", "university"))
+    this->PendingNodeIDs.insert(this->PendingNodeIDs.end(), elem.Refs.begin(), elem.Refs.end());
+  }
+
+  this->PendingRanges.push_back(make_pair(offset, this->PendingNodeIDs.size() - offset));
+
+  //
+  // create building object, which refers to the strings stored
+  // above:
+  //
+  // The node/way id serves as the building id:
+  //
+  Building B(elem.ID, nameView, streetAddrView, {});
+
+  //
+  // add the building to the vector:
+  //
+  this->osmBuildings.push_back(B);
+}
+
+
+/**
+  * @brief called once all elements have been added, sorts by name.
+  *
+  * @return nothing.
+  */
+void Buildings::finishLoading(Nodes& nodes)
+{
+  //
+  // resolve the node ids of every building to indices in the node
+  // table, all into one array:
+  //
+  this->NodeIndices.clear();
+  this->NodeIndices.reserve(this->PendingNodeIDs.size());
+
+  vector<pair<size_t, size_t>> resolved;
+
+  for (pair<size_t, size_t> range : this->PendingRanges)
+  {
+    size_t offset = this->NodeIndices.size();
+
+    for (size_t i = range.first; i < range.first + range.second; i++)
     {
-      string name = osmGetKeyValue(element, "name");
-      
-      if (name == "") { // no name, ignore!
-        element = element->NextSiblingElement();
+      int index = nodes.findIndex(this->PendingNodeIDs[i]);
+
+      if (index < 0) {  // not in the map:
+        this->NumMissingNodes++;
         continue;
       }
 
-      string streetAddr = osmGetKeyValue(element, "addr:housenumber")
-        + " "
-        + osmGetKeyValue(element, "addr:street");
-
-      //
-      // create building object, then add the associated
-      // node ids to the object:
-      //
-      // The node/way id serves as the amenity id:
-      //
-      long long id = attr->Int64Value();
-
-      Building B(id, name, streetAddr);
-      
-      if (tag == "node") {
-        //
-        // this node defines the position of the building, so
-        // add to vector of node references as our only ref:
-        //
-        B.add(id);
-      }
-      else {
-        assert(tag == "way");
-        
-        //
-        // the way has a list of nodes that define the perimeter,
-        // so collect the node ids as references to the perimeter
-        // nodes:
-        //
-        XMLElement* nd = element->FirstChildElement("nd");
-        
-        while (nd != nullptr)
-        {
-          const XMLAttribute* ndref = nd->FindAttribute("ref");
-          assert(ndref != nullptr);
-
-          long long id = ndref->Int64Value();
-
-          B.add(id);
-
-          // advance to next node ref:
-          nd = nd->NextSiblingElement("nd");
-        }
-      }//else
-
-      //
-      // add the building to the vector:
-      //
-      this->osmBuildings.push_back(B);
-    }//if
+      this->NodeIndices.push_back((uint32_t) index);
+    }
+
+    resolved.push_back(make_pair(offset, this->NodeIndices.size() - offset));
+  }
+
+  //
+  // the array is complete, so it's safe to hand out views of it;
+  // the locations and bounding boxes are computed now, once:
+  //
+  NodeTable table = nodes.getTable();
+
+  for (size_t i = 0; i < resolved.size(); i++)
+  {
+    span<const uint32_t> indices(this->NodeIndices.data() + resolved[i].first, resolved[i].second);
+
+    this->osmBuildings[i].setNodeIndices(indices);
+    this->osmBuildings[i].setGeometry(table);
+  }
+
+  vector<long long>().swap(this->PendingNodeIDs);
+  vector<pair<size_t, size_t>>().swap(this->PendingRanges);
+
 
-    element = element->NextSiblingElement();
-  }//while
-  
   //
   // we have all the buildings, sort by name:
   //
 
   sort(osmBuildings.begin(), osmBuildings.end(), 
-  [](Building b1, Building b2) -> bool
+  [](const Building& b1, const Building& b2) -> bool
   {
     if (b1.getName() < b2.getName()) {
       return true;
@@ -149,6 +260,7 @@ Buildings::Buildings(XMLDocument& xmldoc)
   }
   );
 
+  this->buildNameIndex();
   
   //
   // done:
@@ -157,34 +269,114 @@ Buildings::Buildings(XMLDocument& xmldoc)
 }
 
 
+/**
+  * @brief saves the buildings to a snapshot.
+  *
+  * @param out The snapshot being written.
+  * @return nothing.
+  */
+void Buildings::writeSnapshot(SnapshotWriter& out)
+{
+  for (Building& B : this->osmBuildings)
+  {
+    SnapshotBuilding record = {};
+
+    record.ID = B.getID();
+    record.Name = out.addString(B.getName());
+    record.StreetAddress = out.addString(B.getStreetAddress());
+    record.NodeIndicesOffset = out.addNodeIndices(B.getNodeIndices());
+    record.NodeIndicesCount = B.getNodeIndices().size();
+
+    out.BuildingTable.push_back(record);
+  }
+}
+
+
+/**
+  * @brief switches to using the buildings of a (mapped) snapshot in place.
+  *
+  * The snapshot was taken after finishLoading( ), so the records
+  * are already in sorted order. The buildings refer directly to
+  * the snapshot's strings and node indices, nothing is copied;
+  * only the locations and bounding boxes are computed.
+  *
+  * @param snapshot The snapshot, which stays mapped while in use.
+  * @return nothing.
+  */
+void Buildings::readSnapshot(shared_ptr<Snapshot> snapshot)
+{
+  this->osmBuildings.clear();
+  this->NodeIndices.clear();
+  this->PendingNodeIDs.clear();
+  this->PendingRanges.clear();
+  this->NumMissingNodes = 0;
+
+  this->Mapped = snapshot;
+
+  NodeTable table = snapshot->getNodes();
+
+  for (const SnapshotBuilding& record : snapshot->getBuildings())
+  {
+    Building B(record.ID, 
+      snapshot->getString(record.Name),
+      snapshot->getString(record.StreetAddress),
+      snapshot->getNodeIndices(record.NodeIndicesOffset, record.NodeIndicesCount));
+
+    B.setGeometry(table);
+
+    this->osmBuildings.push_back(B);
+  }
+
+  this->buildNameIndex();
+}
+
+
+/**
+  * @brief # of node references that were not in the map.
+  *
+  * @return the # of node ids dropped by finishLoading.
+  */
+int Buildings::getNumMissingNodes() const
+{
+  return this->NumMissingNodes;
+}
+
+
 /**
   * @brief prints all the buildings in summary form.
   *
+  * @param out Where to print, the console by default.
   * @return nothing
   */
-void Buildings::print()
+void Buildings::print(ostream& out) const
 {
-  for (Building B : this->osmBuildings) {
-    B.print();
+  for (const Building& B : this->osmBuildings) {
+    B.print(out);
   }
   
   return;
 }
 
 void Buildings::findAndPrint(Buildings& buildings, Nodes& nodes, int num_of_buildings)
+{
+  string name;
+  getline(cin, name);  // read rest of line in case multiple words in building name
+
+  buildings.findAndPrint(name, nodes, cout);
+}
+
+void Buildings::findAndPrint(string name, const Nodes& nodes, ostream& out) const
 {
   //
   // b ENTER => just list all the buildings
   // b building_name ENTER => search for buildings containing that name
   //
-  string name;
-  getline(cin, name);  // read rest of line in case multiple words in building name
   while (isspace(name[0])) {
     name.erase(0, 1);
   }
 
   if (name == "") {
-    buildings.print();
+    this->print(out);
   }
 
   else {
@@ -193,20 +385,14 @@ void Buildings::findAndPrint(Buildings& buildings, Nodes& nodes, int num_of_buil
     // a case-insensitive search and print a detailed output:
     //
 
-    string check_name = toLowerBuildings(name);
-    bool check = false;
-
-    for (int i = 0; i < num_of_buildings; i++){
-      string lowercase_building = toLowerBuildings(this->osmBuildings[i].getName());
+    vector<int> matches = this->findByName(name);
 
-      if (lowercase_building.find(check_name) != string::npos){
-        this->osmBuildings[i].print(nodes);
-        check = true;
-      }
+    for (int i : matches){
+      this->osmBuildings[i].print(nodes, out);
     }
 
-    if (check == false){
-      cout << "No such building" << endl;
+    if (matches.empty()){
+      out << "No such building" << '\n';
     }
 
   }
@@ -217,28 +403,171 @@ void Buildings::findAndPrint(Buildings& buildings, Nodes& nodes, int num_of_buil
 
 vector< pair < int, pair <double, double> > > Buildings::fast_food_search(Buildings& buildings, Nodes& nodes, int num_of_buildings)
 {
-  vector < pair < int, pair <double, double> > > result;
-
   string building_name;
   getline(cin, building_name);  // read rest of line in case multiple words in building_name
 
-  while (isspace(building_name[0])){
-    building_name.erase(0, 1);
+  return buildings.fast_food_search(building_name);
+}
+
+vector< pair < int, pair <double, double> > > Buildings::fast_food_search(string building_name) const
+{
+  vector < pair < int, pair <double, double> > > result;
+
+  // Check if input text matches each building
+  for (int i : this->findByName(building_name)){
+    pair <double, double> coordinates = this->osmBuildings[i].getLocation();
+    pair < int, pair <double, double> > value = make_pair(i, coordinates);
+    result.push_back(value);
+  }
+
+  return result;
+}
+
+
+/**
+  * @brief the buildings whose name contains the given text,
+  * ignoring case.
+  *
+  * @param name The text to search for; leading spaces are ignored.
+  * @return the positions in osmBuildings, in order
+  */
+vector<int> Buildings::findByName(string name) const
+{
+  vector<int> matches;
+
+  while (isspace(name[0])){
+    name.erase(0, 1);
   } 
 
-  string check_name = toLowerBuildings(building_name);
+  string check_name = toLowerBuildings(name);
+
+  //
+  // too short to have a trigram, so check every name:
+  //
+  if (check_name.size() < 3) {
+    for (size_t i = 0; i < this->LowerNames.size(); i++){
+      if (this->LowerNames[i].find(check_name) != string::npos){
+        matches.push_back((int) i);
+      }
+    }
+
+    return matches;
+  }
+
+  //
+  // the candidates contain every trigram of the text; intersect
+  // the posting lists, shortest first:
+  //
+  vector<const pmr::vector<int>*> postings;
 
-  // Loop through all the buildings to check
-  for (int i = 0; i < num_of_buildings; i++){
-    string lowercase_building = toLowerBuildings(buildings.osmBuildings[i].getName());
+  for (size_t i = 0; i + 3 <= check_name.size(); i++){
+    pmr::unordered_map<uint32_t, pmr::vector<int>>::const_iterator it = this->NameTrigrams.find(trigramOf(check_name, i));
 
-    // Check if input text matches each building
-    if (lowercase_building.find(check_name) != string::npos){
-      pair <double, double> coordinates = buildings.osmBuildings[i].getLocation(nodes);
-      pair < int, pair <double, double> > value = make_pair(i, coordinates);
-      result.push_back(value);
+    if (it == this->NameTrigrams.end()){
+      return matches;  // no name has this trigram
     }
+
+    postings.push_back(&it->second);
   }
 
-  return result;
+  sort(postings.begin(), postings.end(), 
+    [](const pmr::vector<int>* p1, const pmr::vector<int>* p2) 
+    { 
+      return (p1->size() != p2->size()) ? p1->size() < p2->size() : less<const pmr::vector<int>*>()(p1, p2); 
+    });
+
+  postings.erase(unique(postings.begin(), postings.end()), postings.end());  // repeated trigrams
+
+  vector<int> candidates(postings[0]->begin(), postings[0]->end());
+  vector<int> common;
+
+  for (size_t p = 1; p < postings.size() && !candidates.empty(); p++){
+    common.clear();
+    set_intersection(candidates.begin(), candidates.end(), postings[p]->begin(), postings[p]->end(), back_inserter(common));
+    candidates.swap(common);
+  }
+
+  //
+  // having the trigrams doesn't mean they're in the right order,
+  // so check the candidates:
+  //
+  for (int i : candidates){
+    if (this->LowerNames[i].find(check_name) != string::npos){
+      matches.push_back(i);
+    }
+  }
+
+  return matches;
+}
+
+
+//
+// indexes the lowercase names by trigram; the postings are
+// positions in osmBuildings, so this is called after sorting:
+//
+void Buildings::buildNameIndex()
+{
+  this->LowerNames.clear();
+  this->NameTrigrams.clear();
+
+  for (size_t i = 0; i < this->osmBuildings.size(); i++)
+  {
+    this->LowerNames.push_back(this->Strings->intern(toLowerBuildings(this->osmBuildings[i].getName())));
+
+    string_view name = this->LowerNames.back();
+
+    for (size_t j = 0; j + 3 <= name.size(); j++)
+    {
+      pmr::vector<int>& posting = this->NameTrigrams[trigramOf(name, j)];
+
+      if (posting.empty() || posting.back() != (int) i) {  // once per building
+        posting.push_back((int) i);
+      }
+    }
+  }
+}
+
+
+/**
+  * @brief where a walk from a building starts: where its entrances
+  * join the walking graph, or where its location does.
+  *
+  * @param building The position of the building in osmBuildings.
+  * @param nodes The nodes of the map.
+  * @param graph The walking graph.
+  * @return each vertex, and the distance to it in miles
+  */
+vector<pair<uint32_t, double>> Buildings::getWalkingSources(int building, const Nodes& nodes, const Graph& graph) const
+{
+  vector<pair<uint32_t, double>> sources;
+
+  const Building& B = this->osmBuildings[building];
+  NodeTable table = nodes.getTable();
+
+  for (uint32_t index : B.getNodeIndices())
+  {
+    if (!table.getIsEntrance(index)) {
+      continue;
+    }
+
+    double distance;
+    int vertex = graph.nearestVertex(table.getLat(index), table.getLon(index), distance);
+
+    if (vertex >= 0) {
+      sources.push_back(make_pair((uint32_t) vertex, distance));
+    }
+  }
+
+  if (sources.empty())
+  {
+    pair<double, double> location = B.getLocation();
+    double distance;
+    int vertex = graph.nearestVertex(location.first, location.second, distance);
+
+    if (vertex >= 0) {
+      sources.push_back(make_pair((uint32_t) vertex, distance));
+    }
+  }
+
+  return sources;
 }
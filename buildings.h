@@ -9,9 +9,19 @@
 
 #pragma once
 
+#include <iostream>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+#include <memory_resource>
 
 #include "building.h"
+#include "osm.h"
+#include "snapshot.h"
+#include "intern.h"
+#include "graph.h"
 #include "tinyxml2.h"
 
 using namespace std;
@@ -26,6 +36,33 @@ class Buildings
 public:
   vector<Building> osmBuildings;
 
+/**
+  * @brief default constructor, creates an empty collection.
+  *
+  * The collection is filled one element at a time by add( )
+  * while streaming through the map file, followed by a call
+  * to finishLoading( ).
+  */
+  Buildings();
+
+/**
+  * @brief creates an empty collection that keeps its text (names, addresses)
+  * in the given pool, and its indexes in the pool's arena, e.g.
+  * to share one pool between collections. By default each
+  * collection has a pool of its own.
+  *
+  * @param strings The pool.
+  */
+  explicit Buildings(shared_ptr<StringPool> strings);
+
+  // the buildings refer to the collection's own storage, so it is
+  // movable but cannot be copied; its containers are tied to its
+  // arena, so it can't be assigned either:
+  Buildings(const Buildings& other) = delete;
+  Buildings& operator=(const Buildings& other) = delete;
+  Buildings(Buildings&& other) = default;
+  Buildings& operator=(Buildings&& other) = delete;
+
 /**
   * @brief constructor to retrieve all the buildings from the open street map.
   *
@@ -33,18 +70,154 @@ public:
   * stores all the buildings into the vector data member.
   * 
   * @param xmldoc An XML document object denoting the open street map.
+  * @param nodes The nodes of the map, already loaded.
+  * @return nothing.
+  */
+  Buildings(XMLDocument& xmldoc, Nodes& nodes);
+
+/**
+  * @brief stores the given element if it's a named university building.
+  *
+  * @param elem A node or way from the open street map.
+  * @return nothing.
+  */
+  void add(const OsmElement& elem);
+
+/**
+  * @brief called once all elements have been added, resolves the
+  * buildings' node ids to indices in the node table and sorts the
+  * buildings by name.
+  *
+  * Node ids that are not in the map are dropped (and counted, see
+  * getNumMissingNodes), so the nodes of a building can be used
+  * without further lookups. Call this once, after the nodes have
+  * finished loading.
+  *
+  * @param nodes The nodes of the map, already loaded.
   * @return nothing.
   */
-  Buildings(XMLDocument& xmldoc);
+  void finishLoading(Nodes& nodes);
+  
+/**
+  * @brief saves the buildings to a snapshot.
+  *
+  * @param out The snapshot being written.
+  * @return nothing.
+  */
+  void writeSnapshot(SnapshotWriter& out);
+
+/**
+  * @brief switches to using the buildings of a (mapped) snapshot in place.
+  *
+  * @param snapshot The snapshot, which stays mapped while in use.
+  * @return nothing.
+  */
+  void readSnapshot(shared_ptr<Snapshot> snapshot);
+
+/**
+  * @brief # of node references that were not in the map.
+  *
+  * @return the # of node ids dropped by finishLoading.
+  */
+  int getNumMissingNodes() const;
   
 /**
   * @brief prints all the buildings in summary form.
   *
+  * @param out Where to print, the console by default.
   * @return nothing
   */
-  void print();
+  void print(ostream& out = cout) const;
   void findAndPrint(Buildings& buildings, Nodes& nodes, int num_of_buildings);
   vector< pair < int, pair <double, double> > > fast_food_search(Buildings& buildings, Nodes& nodes, int num_of_buildings);
+
+/**
+  * @brief the b command: prints every building whose name contains
+  * the given text (ignoring case) in detail, or all the buildings
+  * in summary form if the text is empty.
+  *
+  * The interactive version above reads the text from the rest of
+  * the input line and prints to the console.
+  *
+  * @param name The text to search for; leading spaces are ignored.
+  * @param nodes The nodes of the map.
+  * @param out Where to print.
+  * @return nothing
+  */
+  void findAndPrint(string name, const Nodes& nodes, ostream& out) const;
+
+/**
+  * @brief the buildings whose name contains the given text
+  * (ignoring case), for the f command.
+  *
+  * @param building_name The text to search for; leading spaces are ignored.
+  * @return (position in osmBuildings, location) of each match
+  */
+  vector< pair < int, pair <double, double> > > fast_food_search(string building_name) const;
+
+/**
+  * @brief the buildings whose name contains the given text,
+  * ignoring case.
+  *
+  * Text of 3 or more characters is looked up in a trigram index
+  * of the names, so only buildings containing every trigram of
+  * the text are compared against it.
+  *
+  * @param name The text to search for; leading spaces are ignored.
+  * @return the positions in osmBuildings, in order
+  */
+  vector<int> findByName(string name) const;
+
+/**
+  * @brief where a walk from a building starts: the vertices where
+  * its entrances join the walking graph (see Graph::nearestVertex),
+  * or where its location does if it has no entrances in the map.
+  *
+  * @param building The position of the building in osmBuildings.
+  * @param nodes The nodes of the map.
+  * @param graph The walking graph.
+  * @return each vertex, and the distance to it in miles (empty if
+  *   the graph is)
+  */
+  vector<pair<uint32_t, double>> getWalkingSources(int building, const Nodes& nodes, const Graph& graph) const;
+
+private:
+  //
+  // the text the buildings refer to, when loaded from the XML; may
+  // be shared with other collections. The containers below that
+  // last as long as the map are allocated from its arena:
+  //
+  shared_ptr<StringPool> Strings;
+
+  //
+  // while loading, the node ids of each building, as (offset, count)
+  // into PendingNodeIDs, in the same order as osmBuildings:
+  //
+  vector<long long> PendingNodeIDs;
+  vector<pair<size_t, size_t>> PendingRanges;
+
+  //
+  // the node indices of all the buildings, back to back; each 
+  // building refers to its part of this array:
+  //
+  pmr::vector<uint32_t> NodeIndices;
+  int NumMissingNodes;
+
+  //
+  // or, when loaded from a snapshot, the mapped snapshot itself:
+  //
+  shared_ptr<Snapshot> Mapped;
+
+  //
+  // the names in lowercase, in the same order as osmBuildings, and
+  // for each trigram (3 lowercase chars packed into an int) of the
+  // names, the positions of the buildings containing it, in order;
+  // built once the buildings are sorted:
+  //
+  pmr::vector<string_view> LowerNames;  // in the string pool
+  pmr::unordered_map<uint32_t, pmr::vector<int>> NameTrigrams;
+
+  void buildNameIndex();
 };
 
 
@@ -12,6 +12,12 @@
   
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #include "dist.h"
 
@@ -26,6 +32,9 @@ static double toRadians(double degrees)
   return (degrees * 3.141592653589 / 180.0);
 }
 
+static const double EARTH_RADIUS_KM = 6371;
+static const double KM_TO_MILES = 0.6213711922;
+
 
 /**
   * @brief computes the distance between 2 GPS coordinates.
@@ -61,3 +70,385 @@ double distBetween2Points(double lat1, double lon1, double lat2, double lon2)
 
   return dist_in_miles;
 }
+
+
+//
+// Approximate distance:
+//
+// With s = max(|dLat|, |dLon|) in radians and phi the average 
+// latitude, the haversine identity
+//
+//   hav(d) = hav(dLat) + cos(lat1) cos(lat2) hav(dLon),
+//
+// with cos(lat1) cos(lat2) = cos^2(phi) - sin^2(dLat / 2) and 
+// 4 hav(x) = x^2 - x^4 / 12 + ..., gives
+//
+//   d^2 = dLat^2 + cos^2(phi) dLon^2 + E,  |E| <= 3/4 s^4 + O(s^6)
+//
+// where the first two terms are the equirectangular distance 
+// squared, which is at least cos^2(phi) s^2. So the relative error
+// is at most 3/8 s^2 / cos^2(phi) + O(s^4); maxError uses 
+// s^2 / cos^2(phi), which more than covers the higher-order terms
+// for s <= 0.1, plus a little for roundoff.
+//
+double distApprox(double lat1, double lon1, double lat2, double lon2)
+{
+  double maxError;
+
+  return distApprox(lat1, lon1, lat2, lon2, maxError);
+}
+
+double distApprox(double lat1, double lon1, double lat2, double lon2, double& maxError)
+{
+  double dLat = toRadians(lat2 - lat1);
+  double dLon = toRadians(lon2 - lon1);
+  double cosPhi = cos(toRadians((lat1 + lat2) / 2));
+
+  double x = dLon * cosPhi;
+  double dist_in_miles = (EARTH_RADIUS_KM * sqrt(x * x + dLat * dLat)) * KM_TO_MILES;
+
+  double s = max(fabs(dLat), fabs(dLon));
+
+  if (s > 0.1 || cosPhi < 0.1) {
+    maxError = numeric_limits<double>::infinity();
+  }
+  else {
+    maxError = dist_in_miles * (s * s / (cosPhi * cosPhi) + 1e-12);
+  }
+
+  return dist_in_miles;
+}
+
+//
+// Batch distances from one point to many:
+//
+// The scalar version is the formula above with cos(lat1) hoisted
+// out of the loop, so it gives exactly the same results. The AVX2
+// and AVX-512 versions compute the same formula 4 / 8 at a time,
+// with sin and atan from the Cephes math library: sin and cos as
+// polynomials on [0, pi/4], atan as a rational function on
+// [0, 0.66] after range reduction.
+//
+
+void distFromPointScalar(double lat, double lon, const double* lats, const double* lons, size_t n, double* distances)
+{
+  double cosLat1 = cos(toRadians(lat));
+
+  for (size_t i = 0; i < n; i++)
+  {
+    double dLat = toRadians(lats[i] - lat);
+    double dLon = toRadians(lons[i] - lon);
+
+    double a = sin(dLat / 2) * sin(dLat / 2) +
+      cosLat1 * cos(toRadians(lats[i])) *
+      sin(dLon / 2) * sin(dLon / 2);
+
+    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
+
+    distances[i] = (EARTH_RADIUS_KM * c) * KM_TO_MILES;
+  }
+}
+
+
+#if defined(__x86_64__)
+
+//
+// Cephes constants:
+//
+static const double PI_HI = 3.141592653589793116;
+static const double PI_LO = 1.2246467991473532e-16;
+static const double PIO2_HI = 1.5707963267948966192;
+static const double PIO2_LO = 6.123233995736766e-17;
+static const double PIO4 = 7.85398163397448309616E-1;
+static const double T3P8 = 2.41421356237309504880;   // tan(3 pi / 8)
+static const double MOREBITS = 6.123233995736765886130E-17;
+
+static const double SIN_COEF[6] = {
+  1.58962301576546568060E-10, -2.50507477628578072866E-8,
+  2.75573136213857245213E-6,  -1.98412698295895385996E-4,
+  8.33333333332211858878E-3,  -1.66666666666666307295E-1
+};
+static const double COS_COEF[6] = {
+  -1.13585365213876817300E-11, 2.08757008419747316778E-9,
+  -2.75573141792967388112E-7,  2.48015872888517045348E-5,
+  -1.38888888888730564116E-3,  4.16666666666665929218E-2
+};
+static const double ATAN_P[5] = {
+  -8.750608600031904122785E-1, -1.615753718733365076637E1,
+  -7.500855792314704667340E1,  -1.228866684490136173410E2,
+  -6.485021904942025371773E1
+};
+static const double ATAN_Q[5] = {  // plus a leading 1
+  2.485846490142306297962E1, 1.650270098316988542046E2,
+  4.328810604912902668951E2, 4.853903996359136964868E2,
+  1.945506571482613964425E2
+};
+
+
+//
+// AVX2: 4 at a time
+//
+__attribute__((target("avx2,fma")))
+static inline __m256d polevl4(__m256d x, const double* coef, int n)
+{
+  __m256d r = _mm256_set1_pd(coef[0]);
+
+  for (int i = 1; i < n; i++) {
+    r = _mm256_fmadd_pd(r, x, _mm256_set1_pd(coef[i]));
+  }
+
+  return r;
+}
+
+//
+// sin(x) for x in [0, pi]; x > pi/2 folds to pi - x, and x > pi/4
+// is computed as cos(pi/2 - x):
+//
+__attribute__((target("avx2,fma")))
+static inline __m256d sin4(__m256d x)
+{
+  __m256d fold = _mm256_cmp_pd(x, _mm256_set1_pd(PIO2_HI), _CMP_GT_OQ);
+  __m256d folded = _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(PI_HI), x), _mm256_set1_pd(PI_LO));
+  x = _mm256_blendv_pd(x, folded, fold);
+
+  __m256d useCos = _mm256_cmp_pd(x, _mm256_set1_pd(PIO4), _CMP_GT_OQ);
+  __m256d comp = _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(PIO2_HI), x), _mm256_set1_pd(PIO2_LO));
+  x = _mm256_blendv_pd(x, comp, useCos);
+
+  __m256d z = _mm256_mul_pd(x, x);
+
+  // sin(x) = x + x z P(z)
+  __m256d s = _mm256_fmadd_pd(_mm256_mul_pd(x, z), polevl4(z, SIN_COEF, 6), x);
+
+  // cos(x) = 1 - z/2 + z^2 Q(z)
+  __m256d c = _mm256_fmadd_pd(_mm256_mul_pd(z, z), polevl4(z, COS_COEF, 6),
+    _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+  return _mm256_blendv_pd(s, c, useCos);
+}
+
+//
+// atan(x) for x >= 0 (including infinity):
+//
+__attribute__((target("avx2,fma")))
+static inline __m256d atan4(__m256d x)
+{
+  __m256d big = _mm256_cmp_pd(x, _mm256_set1_pd(T3P8), _CMP_GT_OQ);
+  __m256d mid = _mm256_andnot_pd(big, _mm256_cmp_pd(x, _mm256_set1_pd(0.66), _CMP_GT_OQ));
+
+  __m256d one = _mm256_set1_pd(1.0);
+  __m256d zero = _mm256_setzero_pd();
+
+  __m256d base = _mm256_blendv_pd(zero, _mm256_set1_pd(PIO4), mid);
+  base = _mm256_blendv_pd(base, _mm256_set1_pd(PIO2_HI), big);
+
+  __m256d corr = _mm256_blendv_pd(zero, _mm256_set1_pd(0.5 * MOREBITS), mid);
+  corr = _mm256_blendv_pd(corr, _mm256_set1_pd(MOREBITS), big);
+
+  __m256d u = _mm256_blendv_pd(x, _mm256_div_pd(_mm256_sub_pd(x, one), _mm256_add_pd(x, one)), mid);
+  u = _mm256_blendv_pd(u, _mm256_div_pd(_mm256_set1_pd(-1.0), x), big);
+
+  __m256d z = _mm256_mul_pd(u, u);
+  __m256d q = _mm256_fmadd_pd(polevl4(z, ATAN_Q, 4), z, _mm256_set1_pd(ATAN_Q[4]));
+  q = _mm256_add_pd(q, _mm256_mul_pd(_mm256_mul_pd(z, z), _mm256_mul_pd(_mm256_mul_pd(z, z), z)));
+  __m256d r = _mm256_div_pd(_mm256_mul_pd(z, polevl4(z, ATAN_P, 5)), q);
+
+  r = _mm256_fmadd_pd(u, r, u);
+
+  return _mm256_add_pd(base, _mm256_add_pd(r, corr));
+}
+
+__attribute__((target("avx2,fma")))
+static void distFromPointAVX2(double lat, double lon, const double* lats, const double* lons, size_t n, double* distances)
+{
+  __m256d toRad = _mm256_set1_pd(3.141592653589);
+  __m256d d180 = _mm256_set1_pd(180.0);
+  __m256d half = _mm256_set1_pd(0.5);
+  __m256d one = _mm256_set1_pd(1.0);
+  __m256d lat1 = _mm256_set1_pd(lat);
+  __m256d lon1 = _mm256_set1_pd(lon);
+  __m256d cosLat1 = _mm256_set1_pd(cos(toRadians(lat)));
+  __m256d scale = _mm256_set1_pd(2 * EARTH_RADIUS_KM * KM_TO_MILES);
+  __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+  size_t i = 0;
+
+  for (; i + 4 <= n; i += 4)
+  {
+    __m256d lat2 = _mm256_loadu_pd(lats + i);
+    __m256d lon2 = _mm256_loadu_pd(lons + i);
+
+    // as toRadians( ): degrees * pi / 180
+    __m256d dLat = _mm256_div_pd(_mm256_mul_pd(_mm256_sub_pd(lat2, lat1), toRad), d180);
+    __m256d dLon = _mm256_div_pd(_mm256_mul_pd(_mm256_sub_pd(lon2, lon1), toRad), d180);
+    __m256d lat2r = _mm256_div_pd(_mm256_mul_pd(lat2, toRad), d180);
+
+    // only sin^2 is needed, so the sign of the angle doesn't matter:
+    __m256d sLat = sin4(_mm256_and_pd(_mm256_mul_pd(dLat, half), absMask));
+    __m256d sLon = sin4(_mm256_and_pd(_mm256_mul_pd(dLon, half), absMask));
+
+    // cos(lat2) = sin(pi/2 - |lat2|)
+    __m256d cLat2 = sin4(_mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(PIO2_HI), _mm256_and_pd(lat2r, absMask)), _mm256_set1_pd(PIO2_LO)));
+
+    __m256d a = _mm256_fmadd_pd(_mm256_mul_pd(_mm256_mul_pd(cosLat1, cLat2), sLon), sLon, _mm256_mul_pd(sLat, sLat));
+
+    // atan2(sqrt(a), sqrt(1 - a)), both >= 0:
+    __m256d c = atan4(_mm256_div_pd(_mm256_sqrt_pd(a), _mm256_sqrt_pd(_mm256_sub_pd(one, a))));
+
+    _mm256_storeu_pd(distances + i, _mm256_mul_pd(scale, c));
+  }
+
+  distFromPointScalar(lat, lon, lats + i, lons + i, n - i, distances + i);
+}
+
+
+//
+// AVX-512: 8 at a time, same steps as AVX2
+//
+__attribute__((target("avx512f")))
+static inline __m512d polevl8(__m512d x, const double* coef, int n)
+{
+  __m512d r = _mm512_set1_pd(coef[0]);
+
+  for (int i = 1; i < n; i++) {
+    r = _mm512_fmadd_pd(r, x, _mm512_set1_pd(coef[i]));
+  }
+
+  return r;
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d sin8(__m512d x)
+{
+  __mmask8 fold = _mm512_cmp_pd_mask(x, _mm512_set1_pd(PIO2_HI), _CMP_GT_OQ);
+  __m512d folded = _mm512_add_pd(_mm512_sub_pd(_mm512_set1_pd(PI_HI), x), _mm512_set1_pd(PI_LO));
+  x = _mm512_mask_blend_pd(fold, x, folded);
+
+  __mmask8 useCos = _mm512_cmp_pd_mask(x, _mm512_set1_pd(PIO4), _CMP_GT_OQ);
+  __m512d comp = _mm512_add_pd(_mm512_sub_pd(_mm512_set1_pd(PIO2_HI), x), _mm512_set1_pd(PIO2_LO));
+  x = _mm512_mask_blend_pd(useCos, x, comp);
+
+  __m512d z = _mm512_mul_pd(x, x);
+
+  __m512d s = _mm512_fmadd_pd(_mm512_mul_pd(x, z), polevl8(z, SIN_COEF, 6), x);
+
+  __m512d c = _mm512_fmadd_pd(_mm512_mul_pd(z, z), polevl8(z, COS_COEF, 6),
+    _mm512_fnmadd_pd(_mm512_set1_pd(0.5), z, _mm512_set1_pd(1.0)));
+
+  return _mm512_mask_blend_pd(useCos, s, c);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d atan8(__m512d x)
+{
+  __mmask8 big = _mm512_cmp_pd_mask(x, _mm512_set1_pd(T3P8), _CMP_GT_OQ);
+  __mmask8 mid = (__mmask8) (~big & _mm512_cmp_pd_mask(x, _mm512_set1_pd(0.66), _CMP_GT_OQ));
+
+  __m512d one = _mm512_set1_pd(1.0);
+  __m512d zero = _mm512_setzero_pd();
+
+  __m512d base = _mm512_mask_blend_pd(mid, zero, _mm512_set1_pd(PIO4));
+  base = _mm512_mask_blend_pd(big, base, _mm512_set1_pd(PIO2_HI));
+
+  __m512d corr = _mm512_mask_blend_pd(mid, zero, _mm512_set1_pd(0.5 * MOREBITS));
+  corr = _mm512_mask_blend_pd(big, corr, _mm512_set1_pd(MOREBITS));
+
+  __m512d u = _mm512_mask_blend_pd(mid, x, _mm512_div_pd(_mm512_sub_pd(x, one), _mm512_add_pd(x, one)));
+  u = _mm512_mask_blend_pd(big, u, _mm512_div_pd(_mm512_set1_pd(-1.0), x));
+
+  __m512d z = _mm512_mul_pd(u, u);
+  __m512d q = _mm512_fmadd_pd(polevl8(z, ATAN_Q, 4), z, _mm512_set1_pd(ATAN_Q[4]));
+  q = _mm512_add_pd(q, _mm512_mul_pd(_mm512_mul_pd(z, z), _mm512_mul_pd(_mm512_mul_pd(z, z), z)));
+  __m512d r = _mm512_div_pd(_mm512_mul_pd(z, polevl8(z, ATAN_P, 5)), q);
+
+  r = _mm512_fmadd_pd(u, r, u);
+
+  return _mm512_add_pd(base, _mm512_add_pd(r, corr));
+}
+
+__attribute__((target("avx512f")))
+static void distFromPointAVX512(double lat, double lon, const double* lats, const double* lons, size_t n, double* distances)
+{
+  __m512d toRad = _mm512_set1_pd(3.141592653589);
+  __m512d d180 = _mm512_set1_pd(180.0);
+  __m512d half = _mm512_set1_pd(0.5);
+  __m512d one = _mm512_set1_pd(1.0);
+  __m512d lat1 = _mm512_set1_pd(lat);
+  __m512d lon1 = _mm512_set1_pd(lon);
+  __m512d cosLat1 = _mm512_set1_pd(cos(toRadians(lat)));
+  __m512d scale = _mm512_set1_pd(2 * EARTH_RADIUS_KM * KM_TO_MILES);
+
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8)
+  {
+    __m512d lat2 = _mm512_loadu_pd(lats + i);
+    __m512d lon2 = _mm512_loadu_pd(lons + i);
+
+    __m512d dLat = _mm512_div_pd(_mm512_mul_pd(_mm512_sub_pd(lat2, lat1), toRad), d180);
+    __m512d dLon = _mm512_div_pd(_mm512_mul_pd(_mm512_sub_pd(lon2, lon1), toRad), d180);
+    __m512d lat2r = _mm512_div_pd(_mm512_mul_pd(lat2, toRad), d180);
+
+    __m512d sLat = sin8(_mm512_abs_pd(_mm512_mul_pd(dLat, half)));
+    __m512d sLon = sin8(_mm512_abs_pd(_mm512_mul_pd(dLon, half)));
+
+    __m512d cLat2 = sin8(_mm512_add_pd(_mm512_sub_pd(_mm512_set1_pd(PIO2_HI), _mm512_abs_pd(lat2r)), _mm512_set1_pd(PIO2_LO)));
+
+    __m512d a = _mm512_fmadd_pd(_mm512_mul_pd(_mm512_mul_pd(cosLat1, cLat2), sLon), sLon, _mm512_mul_pd(sLat, sLat));
+
+    // (the masked sqrt sidesteps a bogus uninitialized warning in 
+    // gcc 12's _mm512_sqrt_pd)
+    __m512d c = atan8(_mm512_div_pd(_mm512_maskz_sqrt_pd(0xFF, a), _mm512_maskz_sqrt_pd(0xFF, _mm512_sub_pd(one, a))));
+
+    _mm512_storeu_pd(distances + i, _mm512_mul_pd(scale, c));
+  }
+
+  distFromPointScalar(lat, lon, lats + i, lons + i, n - i, distances + i);
+}
+
+#endif
+
+
+//
+// picks the version for this CPU, once:
+//
+typedef void (*DistFromPointFn)(double, double, const double*, const double*, size_t, double*);
+
+struct DistKernel
+{
+  DistFromPointFn Fn;
+  const char*     Name;
+};
+
+static DistKernel chooseDistKernel()
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f")) {
+    return { distFromPointAVX512, "avx512" };
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return { distFromPointAVX2, "avx2" };
+  }
+#endif
+
+  return { distFromPointScalar, "scalar" };
+}
+
+static const DistKernel& distKernel()
+{
+  static const DistKernel kernel = chooseDistKernel();
+
+  return kernel;
+}
+
+void distFromPoint(double lat, double lon, const double* lats, const double* lons, size_t n, double* distances)
+{
+  distKernel().Fn(lat, lon, lats, lons, n, distances);
+}
+
+const char* distFromPointKernel()
+{
+  return distKernel().Name;
+}
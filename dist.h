@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 
 /**
   * @brief computes the distance between 2 GPS coordinates.
@@ -30,3 +32,74 @@
   */
 double distBetween2Points(double lat1, double lon1, double lat2, double lon2);
 
+
+
+/**
+  * @brief approximates the distance between 2 GPS coordinates.
+  *
+  * Returns the equirectangular ("flat map") distance in miles: the
+  * longitude difference is scaled by the cosine of the average 
+  * latitude, and the result is the straight-line distance. This is
+  * about 3x cheaper than distBetween2Points and, over the short 
+  * distances within a city, much closer than the errors in the map
+  * itself, so it's meant for ranking and pruning candidates; report
+  * distances with distBetween2Points.
+  *
+  * The second version also returns a bound on the error, in miles:
+  * |distBetween2Points(...) - distApprox(...)| <= maxError. Where 
+  * the points are more than 0.1 radians (~5.7 degrees) apart, or 
+  * the average latitude is within ~5.7 degrees of a pole, there is
+  * no useful bound and maxError is infinity.
+  *
+  * @param lat1 Latitude of first coordinate
+  * @param lon1 Longitude of first coordinate
+  * @param lat2 Latitude of second coordinate
+  * @param lon2 Longitude of second coordinate
+  * @param maxError Output: the error bound in miles
+  * @return approximate distance in miles
+  */
+double distApprox(double lat1, double lon1, double lat2, double lon2);
+double distApprox(double lat1, double lon1, double lat2, double lon2, double& maxError);
+
+/**
+  * @brief computes the distances from one GPS coordinate to many.
+  *
+  * Same as calling distBetween2Points(lat, lon, lats[i], lons[i])
+  * for i = 0 .. n-1, but computes cos(lat) once and, on CPUs with
+  * AVX2 or AVX-512, computes 4 or 8 distances at a time. The CPU
+  * is checked once, at the first call. The vector versions use
+  * their own sin / cos / atan, which agree with the C library's 
+  * to within a few units in the last place; coordinates must be
+  * valid (latitudes in [-90, 90], longitudes in [-180, 180]).
+  *
+  * @param lat Latitude of the origin
+  * @param lon Longitude of the origin
+  * @param lats Latitudes of the destinations
+  * @param lons Longitudes of the destinations
+  * @param n # of destinations
+  * @param distances Output: the n distances in miles
+  * @return nothing
+  */
+void distFromPoint(double lat, double lon, const double* lats, const double* lons, size_t n, double* distances);
+
+/**
+  * @brief distFromPoint without vector instructions.
+  *
+  * Gives exactly the same results as distBetween2Points.
+  *
+  * @param lat Latitude of the origin
+  * @param lon Longitude of the origin
+  * @param lats Latitudes of the destinations
+  * @param lons Longitudes of the destinations
+  * @param n # of destinations
+  * @param distances Output: the n distances in miles
+  * @return nothing
+  */
+void distFromPointScalar(double lat, double lon, const double* lats, const double* lons, size_t n, double* distances);
+
+/**
+  * @brief which version distFromPoint uses on this CPU.
+  *
+  * @return "avx512", "avx2" or "scalar"
+  */
+const char* distFromPointKernel();
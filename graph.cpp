@@ -0,0 +1,670 @@
+/*graph.cpp*/
+
+//
+// The walking graph of the map, built from its highway=* ways, and
+// Dijkstra's algorithm, A* and bidirectional A* over it.
+//
+// Jay Rao
+// Northwestern University
+// CS 211
+//
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <functional>
+
+#include "graph.h"
+#include "dist.h"
+
+using namespace std;
+
+
+//
+// Graph:
+//
+
+//
+// default constructor
+//
+Graph::Graph()
+  : NumMissingNodes(0)
+{
+}
+
+
+//
+// local helper: can this way be walked? Any highway except the
+// ones pedestrians are kept off, unless it says otherwise:
+//
+static bool isWalkable(const OsmElement& elem)
+{
+  static const string_view KEYS[] = { "highway", "foot" };
+  string_view values[2];
+
+  osmGetKeyValues(elem, KEYS, values);
+
+  string_view highway = values[0];
+  string_view foot = values[1];
+
+  if (highway == "" || foot == "no") {
+    return false;
+  }
+
+  if (foot == "yes" || foot == "designated") {
+    return true;
+  }
+
+  return highway != "motorway" && highway != "motorway_link" &&
+    highway != "trunk" && highway != "trunk_link" &&
+    highway != "construction" && highway != "proposed";
+}
+
+
+//
+// add
+//
+void Graph::add(const OsmElement& elem)
+{
+  if (elem.ElemKind != OsmElement::WAY || elem.Refs.size() < 2) {
+    return;
+  }
+
+  if (!isWalkable(elem)) {
+    return;
+  }
+
+  size_t offset = this->PendingNodeIDs.size();
+
+  this->PendingNodeIDs.insert(this->PendingNodeIDs.end(), elem.Refs.begin(), elem.Refs.end());
+  this->PendingRanges.push_back(make_pair(offset, elem.Refs.size()));
+}
+
+
+//
+// finishLoading
+//
+// Every way contributes an edge, in both directions, between each
+// two consecutive nodes that are in the map. Ways that share a
+// stretch (e.g. a sidewalk mapped twice) would give the same edge
+// twice, so only the shortest of each is kept.
+//
+void Graph::finishLoading(Nodes& nodes)
+{
+  struct Edge
+  {
+    uint32_t From;
+    uint32_t To;
+    float    Weight;
+  };
+
+  NodeTable table = nodes.getTable();
+  vector<Edge> edges;
+  vector<uint32_t> way;
+
+  for (pair<size_t, size_t> range : this->PendingRanges)
+  {
+    way.clear();
+
+    for (size_t i = range.first; i < range.first + range.second; i++)
+    {
+      int index = nodes.findIndex(this->PendingNodeIDs[i]);
+
+      if (index < 0) {  // not in the map:
+        this->NumMissingNodes++;
+        continue;
+      }
+
+      way.push_back((uint32_t) index);
+    }
+
+    for (size_t i = 1; i < way.size(); i++)
+    {
+      uint32_t u = way[i - 1];
+      uint32_t v = way[i];
+
+      if (u == v) {
+        continue;
+      }
+
+      float weight = (float) distBetween2Points(table.getLat(u), table.getLon(u), table.getLat(v), table.getLon(v));
+
+      edges.push_back(Edge{ u, v, weight });
+      edges.push_back(Edge{ v, u, weight });
+    }
+  }
+
+  vector<long long>().swap(this->PendingNodeIDs);
+  vector<pair<size_t, size_t>>().swap(this->PendingRanges);
+
+  sort(edges.begin(), edges.end(),
+    [](const Edge& e1, const Edge& e2) -> bool
+    {
+      if (e1.From != e2.From) return e1.From < e2.From;
+      if (e1.To != e2.To) return e1.To < e2.To;
+      return e1.Weight < e2.Weight;
+    }
+  );
+
+  edges.erase(unique(edges.begin(), edges.end(),
+    [](const Edge& e1, const Edge& e2) -> bool
+    {
+      return e1.From == e2.From && e1.To == e2.To;
+    }), edges.end());
+
+  //
+  // count the edges of each vertex, then lay them out:
+  //
+  size_t numVertices = table.size();
+
+  this->EdgeOffsets.assign(numVertices + 1, 0);
+  this->EdgeTargets.clear();
+  this->EdgeWeights.clear();
+  this->EdgeTargets.reserve(edges.size());
+  this->EdgeWeights.reserve(edges.size());
+
+  for (const Edge& e : edges)
+  {
+    this->EdgeOffsets[e.From + 1]++;
+    this->EdgeTargets.push_back(e.To);
+    this->EdgeWeights.push_back(e.Weight);
+  }
+
+  partial_sum(this->EdgeOffsets.begin(), this->EdgeOffsets.end(), this->EdgeOffsets.begin());
+
+  this->Offsets = this->EdgeOffsets;
+  this->Targets = this->EdgeTargets;
+  this->Weights = this->EdgeWeights;
+  this->Table = table;
+  this->Mapped = nullptr;
+
+  this->buildVertexIndex(table);
+}
+
+
+//
+// writeSnapshot
+//
+void Graph::writeSnapshot(SnapshotWriter& out)
+{
+  out.GraphOffsets.assign(this->Offsets.begin(), this->Offsets.end());
+  out.GraphTargets.assign(this->Targets.begin(), this->Targets.end());
+  out.GraphWeights.assign(this->Weights.begin(), this->Weights.end());
+}
+
+
+//
+// readSnapshot
+//
+// The edges are used in place; only the index of the vertices
+// for nearestVertex( ) is rebuilt.
+//
+void Graph::readSnapshot(shared_ptr<Snapshot> snapshot)
+{
+  vector<uint32_t>().swap(this->EdgeOffsets);
+  vector<uint32_t>().swap(this->EdgeTargets);
+  vector<float>().swap(this->EdgeWeights);
+  this->PendingNodeIDs.clear();
+  this->PendingRanges.clear();
+  this->NumMissingNodes = 0;
+
+  this->Mapped = snapshot;
+
+  this->Offsets = snapshot->getGraphOffsets();
+  this->Targets = snapshot->getGraphTargets();
+  this->Weights = snapshot->getGraphWeights();
+  this->Table = snapshot->getNodes();
+
+  this->buildVertexIndex(snapshot->getNodes());
+}
+
+
+//
+// setEdges
+//
+void Graph::setEdges(span<const uint32_t> offsets, span<const uint32_t> targets, span<const float> weights, NodeTable table)
+{
+  vector<uint32_t>().swap(this->EdgeOffsets);
+  vector<uint32_t>().swap(this->EdgeTargets);
+  vector<float>().swap(this->EdgeWeights);
+  this->PendingNodeIDs.clear();
+  this->PendingRanges.clear();
+  this->NumMissingNodes = 0;
+
+  this->Mapped = nullptr;
+
+  this->Offsets = offsets;
+  this->Targets = targets;
+  this->Weights = weights;
+  this->Table = table;
+
+  this->Vertices = SpatialIndex();
+  this->Vertices.build();
+}
+
+
+//
+// indexes the locations of the vertices in the largest connected
+// part of the graph, found by union-find over the edges:
+//
+void Graph::buildVertexIndex(NodeTable table)
+{
+  size_t numVertices = this->getNumVertices();
+  vector<uint32_t> parent(numVertices);
+
+  iota(parent.begin(), parent.end(), 0);
+
+  auto root = [&](uint32_t v) -> uint32_t
+  {
+    while (parent[v] != v) {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+    return v;
+  };
+
+  for (uint32_t u = 0; u < numVertices; u++) {
+    for (uint32_t v : this->getTargets(u)) {
+      parent[root(u)] = root(v);
+    }
+  }
+
+  vector<uint32_t> sizes(numVertices, 0);
+  uint32_t largest = 0;
+
+  for (uint32_t v = 0; v < numVertices; v++)
+  {
+    if (this->getTargets(v).empty()) {
+      continue;
+    }
+
+    uint32_t r = root(v);
+
+    sizes[r]++;
+
+    if (sizes[r] > sizes[largest]) {
+      largest = r;
+    }
+  }
+
+  this->Vertices = SpatialIndex();
+
+  for (uint32_t v = 0; v < numVertices; v++)
+  {
+    if (!this->getTargets(v).empty() && root(v) == largest) {
+      this->Vertices.add((int) v, table.getLat(v), table.getLon(v));
+    }
+  }
+
+  this->Vertices.build();
+}
+
+
+//
+// accessors / getters
+//
+int Graph::getNumMissingNodes() const
+{
+  return this->NumMissingNodes;
+}
+
+size_t Graph::getNumVertices() const
+{
+  return this->Offsets.empty() ? 0 : this->Offsets.size() - 1;
+}
+
+size_t Graph::getNumEdges() const
+{
+  return this->Targets.size();
+}
+
+double Graph::getLat(uint32_t vertex) const
+{
+  return this->Table.getLat(vertex);
+}
+
+double Graph::getLon(uint32_t vertex) const
+{
+  return this->Table.getLon(vertex);
+}
+
+NodeTable Graph::getTable() const
+{
+  return this->Table;
+}
+
+span<const uint32_t> Graph::getTargets(uint32_t vertex) const
+{
+  return this->Targets.subspan(this->Offsets[vertex], this->Offsets[vertex + 1] - this->Offsets[vertex]);
+}
+
+span<const float> Graph::getWeights(uint32_t vertex) const
+{
+  return this->Weights.subspan(this->Offsets[vertex], this->Offsets[vertex + 1] - this->Offsets[vertex]);
+}
+
+
+//
+// nearestVertex
+//
+int Graph::nearestVertex(double lat, double lon, double& distance) const
+{
+  vector<SpatialIndex::Neighbor> nearest = this->Vertices.nearest(lat, lon, 1);
+
+  if (nearest.empty()) {
+    distance = -1;
+    return -1;
+  }
+
+  distance = nearest[0].Distance;
+
+  return nearest[0].Item;
+}
+
+
+//
+// GraphSearch:
+//
+
+//
+// default constructor
+//
+GraphSearch::GraphSearch()
+  : SearchGraph(nullptr), Toward(-1), AwayFrom(-1), NumSettled(0)
+{
+}
+
+
+//
+// forThisThread
+//
+GraphSearch& GraphSearch::forThisThread(int which)
+{
+  thread_local GraphSearch searches[2];
+
+  return searches[which];
+}
+
+
+//
+// start
+//
+// Only the vertices the last search reached are reset; the arrays
+// grow to fit the largest graph searched, and are then reused.
+//
+void GraphSearch::start(const Graph& graph)
+{
+  const double INF = numeric_limits<double>::infinity();
+
+  for (uint32_t v : this->Reached) {
+    this->Distances[v] = INF;
+  }
+
+  this->Reached.clear();
+  this->Heap.clear();
+
+  if (this->Distances.size() < graph.getNumVertices()) {
+    this->Distances.resize(graph.getNumVertices(), INF);
+    this->Potentials.resize(graph.getNumVertices(), 0);
+  }
+
+  this->SearchGraph = &graph;
+  this->Toward = -1;
+  this->AwayFrom = -1;
+  this->NumSettled = 0;
+}
+
+
+//
+// setTarget
+//
+void GraphSearch::setTarget(uint32_t target)
+{
+  this->Toward = (int) target;
+  this->AwayFrom = -1;
+}
+
+void GraphSearch::setTarget(uint32_t target, uint32_t source)
+{
+  this->Toward = (int) target;
+  this->AwayFrom = (int) source;
+}
+
+
+//
+// the potential of a vertex: 0 for Dijkstra, the straight-line
+// distance to the target for A*, or half the difference between
+// the straight-line distances to the target and from the source
+// for bidirectional A*. A straight line is never longer than the
+// paths, so no edge gets a negative length in the search's eyes;
+// the potentials are shaved a little so that holds for edge
+// lengths rounded to float, too:
+//
+double GraphSearch::potential(uint32_t vertex) const
+{
+  if (this->Toward < 0) {
+    return 0;
+  }
+
+  const double SHAVE = 1 - 1e-6;
+
+  const Graph& G = *this->SearchGraph;
+  double lat = G.getLat(vertex), lon = G.getLon(vertex);
+  double toTarget = distBetween2Points(lat, lon, G.getLat(this->Toward), G.getLon(this->Toward));
+
+  if (this->AwayFrom < 0) {
+    return toTarget * SHAVE;
+  }
+
+  double fromSource = distBetween2Points(lat, lon, G.getLat(this->AwayFrom), G.getLon(this->AwayFrom));
+
+  return (toTarget - fromSource) / 2 * SHAVE;
+}
+
+
+//
+// addSource
+//
+void GraphSearch::addSource(uint32_t vertex, double distance)
+{
+  if (distance >= this->Distances[vertex]) {
+    return;
+  }
+
+  if (this->Distances[vertex] == numeric_limits<double>::infinity()) {
+    this->Reached.push_back(vertex);
+    this->Potentials[vertex] = this->potential(vertex);
+  }
+
+  this->Distances[vertex] = distance;
+  this->Heap.push_back(make_pair(distance + this->Potentials[vertex], vertex));
+  push_heap(this->Heap.begin(), this->Heap.end(), greater<pair<double, uint32_t>>());
+}
+
+
+//
+// drops the heap entries at the top that are out of date (the
+// vertex was reached by a shorter path since):
+//
+void GraphSearch::dropStale()
+{
+  while (!this->Heap.empty())
+  {
+    pair<double, uint32_t> top = this->Heap.front();
+
+    if (top.first <= this->Distances[top.second] + this->Potentials[top.second]) {
+      return;
+    }
+
+    pop_heap(this->Heap.begin(), this->Heap.end(), greater<pair<double, uint32_t>>());
+    this->Heap.pop_back();
+  }
+}
+
+
+//
+// next
+//
+// Pops the heap until an entry that is still current comes up,
+// then relaxes that vertex's edges. Edge lengths (less the change
+// in potential) are never negative, so a vertex's distance is 
+// final once it's popped, and any later entries for it are stale.
+//
+bool GraphSearch::next(uint32_t& vertex, double& distance)
+{
+  this->dropStale();
+
+  if (this->Heap.empty()) {
+    return false;
+  }
+
+  pop_heap(this->Heap.begin(), this->Heap.end(), greater<pair<double, uint32_t>>());
+
+  vertex = this->Heap.back().second;
+  distance = this->Distances[vertex];
+
+  this->Heap.pop_back();
+  this->NumSettled++;
+
+  span<const uint32_t> targets = this->SearchGraph->getTargets(vertex);
+  span<const float> weights = this->SearchGraph->getWeights(vertex);
+
+  for (size_t i = 0; i < targets.size(); i++) {
+    this->addSource(targets[i], distance + weights[i]);
+  }
+
+  return true;
+}
+
+
+//
+// getNextKey
+//
+double GraphSearch::getNextKey()
+{
+  this->dropStale();
+
+  if (this->Heap.empty()) {
+    return numeric_limits<double>::infinity();
+  }
+
+  return this->Heap.front().first;
+}
+
+
+//
+// getDistance / getNumSettled
+//
+double GraphSearch::getDistance(uint32_t vertex) const
+{
+  return this->Distances[vertex];
+}
+
+size_t GraphSearch::getNumSettled() const
+{
+  return this->NumSettled;
+}
+
+
+//
+// shortestDistance
+//
+double shortestDistance(const Graph& graph, uint32_t source, uint32_t target, GraphSearch& search)
+{
+  uint32_t vertex;
+  double distance;
+
+  search.start(graph);
+  search.addSource(source, 0);
+
+  while (search.next(vertex, distance)) {
+    if (vertex == target) {
+      return distance;
+    }
+  }
+
+  return numeric_limits<double>::infinity();
+}
+
+
+//
+// shortestDistanceAStar
+//
+double shortestDistanceAStar(const Graph& graph, uint32_t source, uint32_t target, GraphSearch& search)
+{
+  uint32_t vertex;
+  double distance;
+
+  search.start(graph);
+  search.setTarget(target);
+  search.addSource(source, 0);
+
+  while (search.next(vertex, distance)) {
+    if (vertex == target) {
+      return distance;
+    }
+  }
+
+  return numeric_limits<double>::infinity();
+}
+
+
+//
+// shortestDistanceBidirectional
+//
+// The two searches take turns, whichever has the smaller key next.
+// Each time a vertex is settled, its edges to vertices the other
+// search has reached give a candidate path; the best candidate is
+// the answer once the next keys of the two searches add up to at
+// least its length. The forward and backward potentials sum to 0
+// at every vertex, so the keys add up the same way the distances
+// do.
+//
+double shortestDistanceBidirectional(const Graph& graph, uint32_t source, uint32_t target,
+  GraphSearch& forward, GraphSearch& backward)
+{
+  double best = numeric_limits<double>::infinity();
+
+  forward.start(graph);
+  forward.setTarget(target, source);
+  forward.addSource(source, 0);
+
+  backward.start(graph);
+  backward.setTarget(source, target);
+  backward.addSource(target, 0);
+
+  if (source == target) {
+    return 0;
+  }
+
+  while (true)
+  {
+    double forwardKey = forward.getNextKey();
+    double backwardKey = backward.getNextKey();
+
+    if (forwardKey + backwardKey >= best || forwardKey == numeric_limits<double>::infinity() ||
+      backwardKey == numeric_limits<double>::infinity())
+    {
+      break;
+    }
+
+    GraphSearch& search = (forwardKey <= backwardKey) ? forward : backward;
+    GraphSearch& other = (forwardKey <= backwardKey) ? backward : forward;
+
+    uint32_t vertex;
+    double distance;
+
+    search.next(vertex, distance);
+
+    span<const uint32_t> targets = graph.getTargets(vertex);
+    span<const float> weights = graph.getWeights(vertex);
+
+    best = min(best, distance + other.getDistance(vertex));
+
+    for (size_t i = 0; i < targets.size(); i++) {
+      best = min(best, distance + weights[i] + other.getDistance(targets[i]));
+    }
+  }
+
+  return best;
+}
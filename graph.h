@@ -0,0 +1,373 @@
+/*graph.h*/
+
+/**
+  * @brief the walking graph of the map.
+  *
+  * The footpaths, streets and other highway=* ways of the map, as
+  * an undirected graph over the nodes of the map: the vertices are
+  * indices in the node table, and there is an edge between every
+  * two consecutive nodes of a way, weighted by the distance between
+  * them in miles (distBetween2Points). The edges are stored in
+  * compressed sparse row (CSR) form: the edges of vertex v are
+  * Targets[Offsets[v] .. Offsets[v+1]), with the matching Weights.
+  *
+  * GraphSearch runs Dijkstra's algorithm over the graph, reusing
+  * its state from one search to the next, or A* when it's given a
+  * target. For point-to-point queries, shortestDistanceAStar and
+  * shortestDistanceBidirectional settle far fewer vertices than
+  * plain Dijkstra (shortestDistance).
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <cstdint>
+
+#include "node.h"
+#include "nodes.h"
+#include "osm.h"
+#include "snapshot.h"
+#include "spatial.h"
+
+using namespace std;
+
+
+/**
+  * @brief the walking graph of the map.
+  */
+class Graph
+{
+public:
+/**
+  * @brief default constructor, creates an empty graph.
+  *
+  * The graph is filled one element at a time by add( ) while
+  * streaming through the map file, followed by a call to
+  * finishLoading( ).
+  */
+  Graph();
+
+  // the edges may refer to the graph's own arrays, so it is
+  // movable but cannot be copied:
+  Graph(const Graph& other) = delete;
+  Graph& operator=(const Graph& other) = delete;
+  Graph(Graph&& other) = default;
+  Graph& operator=(Graph&& other) = default;
+
+/**
+  * @brief stores the given element if it's a way that can be
+  * walked: any highway=* except motorways, trunk roads and ways
+  * under construction, and not tagged foot=no.
+  *
+  * @param elem A node or way from the open street map.
+  * @return nothing.
+  */
+  void add(const OsmElement& elem);
+
+/**
+  * @brief called once all elements have been added, resolves the
+  * ways' node ids to indices in the node table and builds the
+  * edges.
+  *
+  * Node ids that are not in the map are dropped (and counted, see
+  * getNumMissingNodes). The graph uses the node table of the given
+  * nodes, which must not change while the graph exists.
+  *
+  * @param nodes The nodes of the map, already loaded.
+  * @return nothing.
+  */
+  void finishLoading(Nodes& nodes);
+
+/**
+  * @brief saves the edges to a snapshot.
+  *
+  * @param out The snapshot being written.
+  * @return nothing.
+  */
+  void writeSnapshot(SnapshotWriter& out);
+
+/**
+  * @brief switches to using the edges of a (mapped) snapshot in place.
+  *
+  * @param snapshot The snapshot, which stays mapped while in use.
+  * @return nothing.
+  */
+  void readSnapshot(shared_ptr<Snapshot> snapshot);
+
+/**
+  * @brief sets the edges directly, for a graph derived from another
+  * (e.g. the upward graph of a contraction hierarchy).
+  *
+  * The arrays are used in place, so they must outlive the graph.
+  * Vertices are not indexed by location, so nearestVertex( ) finds
+  * nothing in such a graph.
+  *
+  * @param offsets Where the edges of each vertex start, # of vertices + 1.
+  * @param targets The vertex each edge leads to.
+  * @param weights The length of each edge in miles.
+  * @param table The node table, for the locations of the vertices.
+  * @return nothing.
+  */
+  void setEdges(span<const uint32_t> offsets, span<const uint32_t> targets, span<const float> weights, NodeTable table);
+
+/**
+  * @brief # of node references that were not in the map.
+  *
+  * @return the # of node ids dropped by finishLoading.
+  */
+  int getNumMissingNodes() const;
+
+/**
+  * @brief # of vertices, one per node of the map (most of which have
+  * no edges).
+  *
+  * @return the # of vertices.
+  */
+  size_t getNumVertices() const;
+
+/**
+  * @brief # of edges, each counted once per direction.
+  *
+  * @return the # of edges.
+  */
+  size_t getNumEdges() const;
+
+/**
+  * @brief the edges of a vertex: the vertices they lead to, and
+  * their lengths in miles.
+  *
+  * @param vertex The vertex, a node index.
+  * @return the targets / weights, in the same order.
+  */
+  span<const uint32_t> getTargets(uint32_t vertex) const;
+  span<const float> getWeights(uint32_t vertex) const;
+
+/**
+  * @brief the location of a vertex.
+  *
+  * @param vertex The vertex, a node index.
+  * @return the latitude / longitude.
+  */
+  double getLat(uint32_t vertex) const;
+  double getLon(uint32_t vertex) const;
+
+  // read-only view of the node table the vertices are from:
+  NodeTable getTable() const;
+
+/**
+  * @brief the vertex where a walk from the given location joins the
+  * graph: the nearest vertex of the graph's largest connected part,
+  * so that a walk isn't stranded on an isolated bit of path (e.g.
+  * the footways inside a building).
+  *
+  * @param lat Latitude of the location.
+  * @param lon Longitude of the location.
+  * @param distance Output: the distance to the vertex in miles.
+  * @return the vertex, -1 if the graph is empty
+  */
+  int nearestVertex(double lat, double lon, double& distance) const;
+
+private:
+  //
+  // while loading, the node ids of each way, as (offset, count)
+  // into PendingNodeIDs:
+  //
+  vector<long long> PendingNodeIDs;
+  vector<pair<size_t, size_t>> PendingRanges;
+  int NumMissingNodes;
+
+  //
+  // the edges, when built by finishLoading( ):
+  //
+  vector<uint32_t> EdgeOffsets;
+  vector<uint32_t> EdgeTargets;
+  vector<float>    EdgeWeights;
+
+  //
+  // the edges that are searched: either the arrays above, or when
+  // loaded from a snapshot, the snapshot's arrays in place:
+  //
+  span<const uint32_t> Offsets;
+  span<const uint32_t> Targets;
+  span<const float>    Weights;
+  shared_ptr<Snapshot> Mapped;
+
+  //
+  // the node table, for the locations of the vertices:
+  //
+  NodeTable Table;
+
+  //
+  // the vertices of the largest connected part, for nearestVertex( ):
+  //
+  SpatialIndex Vertices;
+
+  void buildVertexIndex(NodeTable table);
+};
+
+
+/**
+  * @brief the state of a Dijkstra search over a Graph, reused from
+  * one search to the next.
+  *
+  * A search starts from one or more source vertices, and settles
+  * the vertices one at a time in order of distance; the caller
+  * decides when to stop. Given a target, the search is A*
+  * instead: vertices are settled in order of distance plus the
+  * straight-line distance left to the target, so the search heads
+  * toward it. The distance of each settled vertex is still its
+  * shortest distance. Starting a new search only resets the
+  * vertices the last one reached, so a search that stops early
+  * costs only what it explored.
+  *
+  * A search is not thread-safe; forThisThread( ) gives each thread
+  * its own.
+  */
+class GraphSearch
+{
+public:
+/**
+  * @brief default constructor.
+  */
+  GraphSearch();
+
+/**
+  * @brief the search state of the calling thread, reused by every
+  * search the thread runs. Each thread has two, for the searches
+  * that go from both ends at once.
+  *
+  * @param which Which of the two, 0 or 1.
+  * @return the search state.
+  */
+  static GraphSearch& forThisThread(int which = 0);
+
+/**
+  * @brief starts a new search over the given graph, which must not
+  * change until the search is done.
+  *
+  * @param graph The graph to search.
+  * @return nothing.
+  */
+  void start(const Graph& graph);
+
+/**
+  * @brief makes the search an A* search toward the given target;
+  * call after start( ), before adding sources.
+  *
+  * The second version is for bidirectional A*, where the searches
+  * from each end must use opposite potentials: it heads toward the
+  * target and away from the source, by half the difference of the
+  * straight-line distances to the two.
+  *
+  * @param target The vertex to head toward.
+  * @param source The vertex to head away from.
+  * @return nothing.
+  */
+  void setTarget(uint32_t target);
+  void setTarget(uint32_t target, uint32_t source);
+
+/**
+  * @brief adds a vertex to start from.
+  *
+  * @param vertex The vertex.
+  * @param distance The distance already covered to get there, in miles.
+  * @return nothing.
+  */
+  void addSource(uint32_t vertex, double distance);
+
+/**
+  * @brief settles the nearest vertex not yet settled.
+  *
+  * @param vertex Output: the vertex.
+  * @param distance Output: its distance in miles.
+  * @return false if every reachable vertex has been settled.
+  */
+  bool next(uint32_t& vertex, double& distance);
+
+/**
+  * @brief the key of the next vertex next( ) would settle: its
+  * distance, plus its potential in an A* search.
+  *
+  * @return the key, infinity if there are no vertices left.
+  */
+  double getNextKey();
+
+/**
+  * @brief the shortest distance to a vertex found so far.
+  *
+  * @param vertex The vertex.
+  * @return the distance in miles, infinity if not reached.
+  */
+  double getDistance(uint32_t vertex) const;
+
+/**
+  * @brief # of vertices settled since start( ).
+  *
+  * @return the # of vertices.
+  */
+  size_t getNumSettled() const;
+
+private:
+  const Graph*     SearchGraph;
+  vector<double>   Distances;   // by vertex, infinity if not reached
+  vector<double>   Potentials;  // by vertex, set when first reached
+  vector<uint32_t> Reached;     // the vertices whose distance is set
+  int              Toward;      // the target, -1 if none
+  int              AwayFrom;    // the source, for bidirectional A*
+  size_t           NumSettled;
+
+  //
+  // min-heap of (key, vertex); a vertex may be in the heap more
+  // than once, only the entry with its current key counts:
+  //
+  vector<pair<double, uint32_t>> Heap;
+
+  double potential(uint32_t vertex) const;
+  void dropStale();
+};
+
+
+/**
+  * @brief the shortest distance between two vertices of a graph,
+  * by Dijkstra's algorithm, stopping once the target is settled.
+  *
+  * @param graph The graph.
+  * @param source The vertex to start from.
+  * @param target The vertex to get to.
+  * @param search The search state to use.
+  * @return the distance in miles, infinity if there is no path
+  */
+double shortestDistance(const Graph& graph, uint32_t source, uint32_t target, GraphSearch& search);
+
+/**
+  * @brief the shortest distance between two vertices of a graph,
+  * by A*, with the straight-line distance to the target
+  * (distBetween2Points) as the estimate of the distance left.
+  *
+  * @param graph The graph.
+  * @param source The vertex to start from.
+  * @param target The vertex to get to.
+  * @param search The search state to use.
+  * @return the distance in miles, infinity if there is no path
+  */
+double shortestDistanceAStar(const Graph& graph, uint32_t source, uint32_t target, GraphSearch& search);
+
+/**
+  * @brief the shortest distance between two vertices of a graph,
+  * by bidirectional A*: an A* search from each end, taking turns,
+  * until the best path where they meet can't be improved.
+  *
+  * @param graph The graph.
+  * @param source The vertex to start from.
+  * @param target The vertex to get to.
+  * @param forward The search state to use from the source.
+  * @param backward The search state to use from the target.
+  * @return the distance in miles, infinity if there is no path
+  */
+double shortestDistanceBidirectional(const Graph& graph, uint32_t source, uint32_t target,
+  GraphSearch& forward, GraphSearch& backward);
@@ -0,0 +1,453 @@
+/*hierarchy.cpp*/
+
+//
+// Contraction hierarchy over the walking graph: preprocessing, and
+// point-to-point and one-to-many queries over the upward graph.
+//
+// Jay Rao
+// Northwestern University
+// CS 211
+//
+
+#include <algorithm>
+#include <limits>
+#include <functional>
+
+#include "hierarchy.h"
+
+using namespace std;
+
+
+//
+// default constructor
+//
+ContractionHierarchy::ContractionHierarchy()
+{
+}
+
+
+//
+// the graph while it's being contracted: the edges of each vertex
+// to the vertices not yet contracted, and a small Dijkstra for the
+// witness searches:
+//
+namespace
+{
+  const double INF = numeric_limits<double>::infinity();
+
+  //
+  // a witness search settles at most this many vertices; if no
+  // witness is found by then, the shortcut is added anyway, which
+  // is never wrong, just more edges:
+  //
+  const int WITNESS_LIMIT = 500;
+
+  struct Contraction
+  {
+    vector<vector<pair<uint32_t, float>>> Edges;
+    vector<int> NumContractedNeighbors;
+    vector<char> Contracted;
+
+    vector<double> Distances;
+    vector<uint32_t> Reached;
+    vector<pair<double, uint32_t>> Heap;
+
+    //
+    // shortest distances from source to the other vertices not yet
+    // contracted, without going through skip, up to the limit:
+    //
+    void witnessSearch(uint32_t source, uint32_t skip, double limit)
+    {
+      for (uint32_t v : this->Reached) {
+        this->Distances[v] = INF;
+      }
+
+      this->Reached.clear();
+      this->Heap.clear();
+
+      this->Distances[source] = 0;
+      this->Reached.push_back(source);
+      this->Heap.push_back(make_pair(0.0, source));
+
+      int numSettled = 0;
+
+      while (!this->Heap.empty() && numSettled < WITNESS_LIMIT)
+      {
+        pop_heap(this->Heap.begin(), this->Heap.end(), greater<pair<double, uint32_t>>());
+
+        pair<double, uint32_t> top = this->Heap.back();
+
+        this->Heap.pop_back();
+
+        if (top.first > this->Distances[top.second]) {  // stale:
+          continue;
+        }
+
+        if (top.first > limit) {
+          break;
+        }
+
+        numSettled++;
+
+        for (pair<uint32_t, float> edge : this->Edges[top.second])
+        {
+          if (edge.first == skip) {
+            continue;
+          }
+
+          double distance = top.first + edge.second;
+
+          if (distance < this->Distances[edge.first])
+          {
+            if (this->Distances[edge.first] == INF) {
+              this->Reached.push_back(edge.first);
+            }
+
+            this->Distances[edge.first] = distance;
+            this->Heap.push_back(make_pair(distance, edge.first));
+            push_heap(this->Heap.begin(), this->Heap.end(), greater<pair<double, uint32_t>>());
+          }
+        }
+      }
+    }
+
+    //
+    // the shortcuts contracting v takes: between each two of its
+    // neighbors, unless a witness path is at least as short:
+    //
+    void findShortcuts(uint32_t v, vector<pair<pair<uint32_t, uint32_t>, float>>& shortcuts)
+    {
+      shortcuts.clear();
+
+      const vector<pair<uint32_t, float>>& edges = this->Edges[v];
+
+      float longest = 0;
+
+      for (pair<uint32_t, float> edge : edges) {
+        longest = max(longest, edge.second);
+      }
+
+      for (size_t i = 0; i < edges.size(); i++)
+      {
+        this->witnessSearch(edges[i].first, v, (double) edges[i].second + longest);
+
+        for (size_t j = i + 1; j < edges.size(); j++)
+        {
+          double through = (double) edges[i].second + edges[j].second;
+
+          if (this->Distances[edges[j].first] > through) {
+            shortcuts.push_back(make_pair(make_pair(edges[i].first, edges[j].first), (float) through));
+          }
+        }
+      }
+    }
+
+    //
+    // adds the edge u - w, or shortens it if it's there:
+    //
+    void addEdge(uint32_t u, uint32_t w, float weight)
+    {
+      for (pair<uint32_t, float>& edge : this->Edges[u])
+      {
+        if (edge.first == w) {
+          edge.second = min(edge.second, weight);
+          return;
+        }
+      }
+
+      this->Edges[u].push_back(make_pair(w, weight));
+    }
+
+    //
+    // the lower, the sooner a vertex should be contracted: the
+    // change in the # of edges, so the graph doesn't grow, plus
+    // the # of neighbors already contracted, so contraction is
+    // spread out over the map:
+    //
+    int priority(uint32_t v, vector<pair<pair<uint32_t, uint32_t>, float>>& shortcuts)
+    {
+      this->findShortcuts(v, shortcuts);
+
+      return (int) shortcuts.size() - (int) this->Edges[v].size() + this->NumContractedNeighbors[v];
+    }
+  };
+}
+
+
+//
+// build
+//
+// The vertices are contracted in order of priority, kept up to
+// date lazily: the vertex at the top of the queue has its priority
+// recomputed, and is only contracted if it's still no worse than
+// the next one.
+//
+void ContractionHierarchy::build(const Graph& graph)
+{
+  size_t numVertices = graph.getNumVertices();
+
+  Contraction C;
+
+  C.Edges.resize(numVertices);
+  C.NumContractedNeighbors.assign(numVertices, 0);
+  C.Contracted.assign(numVertices, 0);
+  C.Distances.assign(numVertices, INF);
+
+  for (uint32_t v = 0; v < numVertices; v++)
+  {
+    span<const uint32_t> targets = graph.getTargets(v);
+    span<const float> weights = graph.getWeights(v);
+
+    for (size_t i = 0; i < targets.size(); i++) {
+      C.Edges[v].push_back(make_pair(targets[i], weights[i]));
+    }
+  }
+
+  vector<pair<pair<uint32_t, uint32_t>, float>> shortcuts;
+  vector<pair<int, uint32_t>> queue;
+
+  for (uint32_t v = 0; v < numVertices; v++)
+  {
+    if (!C.Edges[v].empty()) {
+      queue.push_back(make_pair(C.priority(v, shortcuts), v));
+    }
+  }
+
+  make_heap(queue.begin(), queue.end(), greater<pair<int, uint32_t>>());
+
+  //
+  // the upward edges of each vertex, as it's contracted:
+  //
+  vector<vector<pair<uint32_t, float>>> upward(numVertices);
+
+  while (!queue.empty())
+  {
+    pop_heap(queue.begin(), queue.end(), greater<pair<int, uint32_t>>());
+
+    uint32_t v = queue.back().second;
+
+    queue.pop_back();
+
+    int current = C.priority(v, shortcuts);
+
+    if (!queue.empty() && current > queue.front().first)
+    {
+      queue.push_back(make_pair(current, v));
+      push_heap(queue.begin(), queue.end(), greater<pair<int, uint32_t>>());
+      continue;
+    }
+
+    //
+    // contract v: its remaining edges become its upward edges, and
+    // the shortcuts join up its neighbors without it:
+    //
+    upward[v] = C.Edges[v];
+    C.Contracted[v] = 1;
+
+    for (pair<uint32_t, float> edge : C.Edges[v])
+    {
+      vector<pair<uint32_t, float>>& back = C.Edges[edge.first];
+
+      back.erase(remove_if(back.begin(), back.end(),
+        [&](const pair<uint32_t, float>& e) { return e.first == v; }), back.end());
+
+      C.NumContractedNeighbors[edge.first]++;
+    }
+
+    for (const pair<pair<uint32_t, uint32_t>, float>& shortcut : shortcuts)
+    {
+      C.addEdge(shortcut.first.first, shortcut.first.second, shortcut.second);
+      C.addEdge(shortcut.first.second, shortcut.first.first, shortcut.second);
+    }
+
+    vector<pair<uint32_t, float>>().swap(C.Edges[v]);
+  }
+
+  //
+  // lay out the upward edges:
+  //
+  this->UpOffsets.assign(numVertices + 1, 0);
+  this->UpTargets.clear();
+  this->UpWeights.clear();
+
+  for (uint32_t v = 0; v < numVertices; v++)
+  {
+    sort(upward[v].begin(), upward[v].end());
+
+    for (pair<uint32_t, float> edge : upward[v]) {
+      this->UpTargets.push_back(edge.first);
+      this->UpWeights.push_back(edge.second);
+    }
+
+    this->UpOffsets[v + 1] = (uint32_t) this->UpTargets.size();
+  }
+
+  this->Mapped = nullptr;
+  this->Upward.setEdges(this->UpOffsets, this->UpTargets, this->UpWeights, graph.getTable());
+}
+
+
+//
+// writeSnapshot
+//
+void ContractionHierarchy::writeSnapshot(SnapshotWriter& out)
+{
+  const Graph& G = this->Upward;
+
+  out.HierarchyOffsets.clear();
+  out.HierarchyTargets.clear();
+  out.HierarchyWeights.clear();
+
+  if (G.getNumVertices() == 0) {
+    return;
+  }
+
+  out.HierarchyOffsets.push_back(0);
+
+  for (uint32_t v = 0; v < G.getNumVertices(); v++)
+  {
+    span<const uint32_t> targets = G.getTargets(v);
+    span<const float> weights = G.getWeights(v);
+
+    out.HierarchyTargets.insert(out.HierarchyTargets.end(), targets.begin(), targets.end());
+    out.HierarchyWeights.insert(out.HierarchyWeights.end(), weights.begin(), weights.end());
+    out.HierarchyOffsets.push_back((uint32_t) out.HierarchyTargets.size());
+  }
+}
+
+
+//
+// readSnapshot
+//
+void ContractionHierarchy::readSnapshot(shared_ptr<Snapshot> snapshot)
+{
+  vector<uint32_t>().swap(this->UpOffsets);
+  vector<uint32_t>().swap(this->UpTargets);
+  vector<float>().swap(this->UpWeights);
+
+  this->Mapped = snapshot;
+  this->Upward.setEdges(snapshot->getHierarchyOffsets(), snapshot->getHierarchyTargets(),
+    snapshot->getHierarchyWeights(), snapshot->getNodes());
+}
+
+
+//
+// getUpwardGraph
+//
+const Graph& ContractionHierarchy::getUpwardGraph() const
+{
+  return this->Upward;
+}
+
+
+//
+// findDistance
+//
+// The two upward searches take turns, whichever has the nearer
+// vertex next; a path is found wherever they meet, and the best
+// one is the answer once neither search has a vertex nearer than
+// it left.
+//
+double ContractionHierarchy::findDistance(span<const pair<uint32_t, double>> sources, span<const pair<uint32_t, double>> targets,
+  GraphSearch& forward, GraphSearch& backward) const
+{
+  double best = INF;
+
+  forward.start(this->Upward);
+  backward.start(this->Upward);
+
+  for (pair<uint32_t, double> source : sources) {
+    forward.addSource(source.first, source.second);
+  }
+
+  for (pair<uint32_t, double> target : targets) {
+    backward.addSource(target.first, target.second);
+  }
+
+  while (true)
+  {
+    double forwardKey = forward.getNextKey();
+    double backwardKey = backward.getNextKey();
+
+    if (min(forwardKey, backwardKey) >= best) {
+      break;
+    }
+
+    GraphSearch& search = (forwardKey <= backwardKey) ? forward : backward;
+    GraphSearch& other = (forwardKey <= backwardKey) ? backward : forward;
+
+    uint32_t vertex;
+    double distance;
+
+    search.next(vertex, distance);
+
+    best = min(best, distance + other.getDistance(vertex));
+  }
+
+  return best;
+}
+
+
+//
+// prepareTargets
+//
+void ContractionHierarchy::prepareTargets(span<const pair<uint32_t, double>> targets, HierarchyTargets& prepared, GraphSearch& search) const
+{
+  prepared.Buckets.clear();
+  prepared.NumTargets = targets.size();
+
+  for (size_t t = 0; t < targets.size(); t++)
+  {
+    uint32_t vertex;
+    double distance;
+
+    search.start(this->Upward);
+    search.addSource(targets[t].first, targets[t].second);
+
+    while (search.next(vertex, distance)) {
+      prepared.Buckets.push_back(HierarchyTargets::Entry{ vertex, (uint32_t) t, distance });
+    }
+  }
+
+  sort(prepared.Buckets.begin(), prepared.Buckets.end(),
+    [](const HierarchyTargets::Entry& e1, const HierarchyTargets::Entry& e2) -> bool
+    {
+      if (e1.Vertex != e2.Vertex) return e1.Vertex < e2.Vertex;
+      return e1.Target < e2.Target;
+    }
+  );
+}
+
+
+//
+// findDistances
+//
+// Every vertex the upward search from the sources settles may be
+// the top of a path to a target, so its bucket is scanned. The
+// search settles vertices in order of distance, so once it's past
+// the bound nothing it finds can matter.
+//
+void ContractionHierarchy::findDistances(span<const pair<uint32_t, double>> sources, const HierarchyTargets& targets,
+  vector<double>& distances, GraphSearch& search, double bound) const
+{
+  distances.assign(targets.NumTargets, INF);
+
+  search.start(this->Upward);
+
+  for (pair<uint32_t, double> source : sources) {
+    search.addSource(source.first, source.second);
+  }
+
+  uint32_t vertex;
+  double distance;
+
+  while (search.next(vertex, distance) && distance <= bound)
+  {
+    vector<HierarchyTargets::Entry>::const_iterator it = lower_bound(targets.Buckets.begin(), targets.Buckets.end(), vertex,
+      [](const HierarchyTargets::Entry& e, uint32_t v) { return e.Vertex < v; });
+
+    for (; it != targets.Buckets.end() && it->Vertex == vertex; it++) {
+      distances[it->Target] = min(distances[it->Target], distance + it->Distance);
+    }
+  }
+}
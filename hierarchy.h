@@ -0,0 +1,175 @@
+/*hierarchy.h*/
+
+/**
+  * @brief contraction hierarchy over the walking graph.
+  *
+  * Preprocessing ranks the vertices of the walking graph and
+  * "contracts" them one at a time, lowest rank first: a contracted
+  * vertex is taken out of the graph, and wherever the only shortest
+  * path between two of its neighbors went through it, a shortcut
+  * edge between them keeps the distance. Each vertex ends up with
+  * its upward edges, to the neighbors it had when it was contracted
+  * (all of a higher rank), which together form the upward graph.
+  *
+  * Every shortest path then has a shortest-path twin that goes
+  * only up from each end to its highest vertex, so a query searches
+  * only the upward graph, from both ends, and explores a few
+  * hundred vertices rather than a good part of the map. The upward
+  * graph is built once per map and saved in the snapshot.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <limits>
+#include <cstdint>
+
+#include "graph.h"
+#include "snapshot.h"
+
+using namespace std;
+
+
+/**
+  * @brief the targets of one-to-many queries, prepared once for
+  * any number of queries.
+  *
+  * Holds the upward search space of every target, as buckets: for
+  * each vertex reached from a target, the distance to the target.
+  */
+struct HierarchyTargets
+{
+  struct Entry
+  {
+    uint32_t Vertex;
+    uint32_t Target;    // position in the targets given
+    double   Distance;  // from Vertex to the target, in miles
+  };
+
+  vector<Entry> Buckets;  // sorted by vertex
+  size_t NumTargets = 0;
+};
+
+
+/**
+  * @brief contraction hierarchy over the walking graph.
+  */
+class ContractionHierarchy
+{
+public:
+/**
+  * @brief default constructor, creates an empty hierarchy.
+  */
+  ContractionHierarchy();
+
+  // the upward graph may refer to the hierarchy's own arrays, so
+  // it cannot be copied or moved:
+  ContractionHierarchy(const ContractionHierarchy& other) = delete;
+  ContractionHierarchy& operator=(const ContractionHierarchy& other) = delete;
+
+/**
+  * @brief builds the hierarchy over the given graph: orders and
+  * contracts its vertices, adding shortcuts.
+  *
+  * Takes a while for a large map, so it's done once, at load, and
+  * saved in the snapshot. The graph must not change while the
+  * hierarchy exists.
+  *
+  * @param graph The walking graph, finished loading.
+  * @return nothing.
+  */
+  void build(const Graph& graph);
+
+/**
+  * @brief saves the upward graph to a snapshot.
+  *
+  * @param out The snapshot being written.
+  * @return nothing.
+  */
+  void writeSnapshot(SnapshotWriter& out);
+
+/**
+  * @brief switches to using the upward graph of a (mapped) snapshot in place.
+  *
+  * @param snapshot The snapshot, which stays mapped while in use.
+  * @return nothing.
+  */
+  void readSnapshot(shared_ptr<Snapshot> snapshot);
+
+/**
+  * @brief the upward graph: the edges of each vertex that lead to
+  * vertices of a higher rank, shortcuts included.
+  *
+  * Each edge of the walking graph is in it once (from its lower
+  * end), so it has getNumEdges( ) / 2 edges plus the shortcuts.
+  *
+  * @return the upward graph.
+  */
+  const Graph& getUpwardGraph() const;
+
+/**
+  * @brief the shortest distance from any of the sources to any of
+  * the targets.
+  *
+  * Each source / target is a vertex and the distance already
+  * covered to get there (e.g. from a building entrance to where it
+  * joins the graph).
+  *
+  * @param sources The vertices to start from.
+  * @param targets The vertices to get to.
+  * @param forward The search state to use from the sources.
+  * @param backward The search state to use from the targets.
+  * @return the distance in miles, infinity if there is no path
+  */
+  double findDistance(span<const pair<uint32_t, double>> sources, span<const pair<uint32_t, double>> targets,
+    GraphSearch& forward, GraphSearch& backward) const;
+
+/**
+  * @brief prepares the given targets for one-to-many queries.
+  *
+  * @param targets The targets: the vertex of each, and the distance
+  *   from there to the target.
+  * @param prepared Output: the prepared targets.
+  * @param search The search state to use.
+  * @return nothing.
+  */
+  void prepareTargets(span<const pair<uint32_t, double>> targets, HierarchyTargets& prepared, GraphSearch& search) const;
+
+/**
+  * @brief the shortest distance from the sources to each of the
+  * prepared targets, with one upward search from the sources.
+  *
+  * A bound can be given to stop the search early: distances longer
+  * than the bound may then be reported as infinity.
+  *
+  * @param sources The vertices to start from, see findDistance.
+  * @param targets The prepared targets.
+  * @param distances Output: the distance to each target in miles,
+  *   infinity if there is no path.
+  * @param search The search state to use.
+  * @param bound Distances of interest are at most this long.
+  * @return nothing.
+  */
+  void findDistances(span<const pair<uint32_t, double>> sources, const HierarchyTargets& targets,
+    vector<double>& distances, GraphSearch& search, double bound = numeric_limits<double>::infinity()) const;
+
+private:
+  //
+  // the upward graph, when built by build( ):
+  //
+  vector<uint32_t> UpOffsets;
+  vector<uint32_t> UpTargets;
+  vector<float>    UpWeights;
+
+  //
+  // the upward graph that is searched, over either the arrays above
+  // or, when loaded from a snapshot, the snapshot's arrays in place:
+  //
+  Graph Upward;
+  shared_ptr<Snapshot> Mapped;
+};
@@ -0,0 +1,77 @@
+/*intern.cpp*/
+
+//
+// Pool of interned strings, stored back to back in an arena.
+//
+// Jay Rao
+// Northwestern University
+// CS 211
+//
+
+#include <cstring>
+#include <algorithm>
+
+#include "intern.h"
+
+using namespace std;
+
+
+//
+// constructor
+//
+StringPool::StringPool(shared_ptr<Arena> arena)
+  : Memory(arena), NumBytes(0), Interned(arena.get())
+{
+}
+
+
+//
+// intern
+//
+string_view StringPool::intern(string_view s)
+{
+  pmr::unordered_set<string_view>::const_iterator it = this->Interned.find(s);
+
+  if (it != this->Interned.end()) {
+    return *it;
+  }
+
+  char* copy = (char*) this->Memory->allocate(max(s.size(), (size_t) 1), 1);
+
+  memcpy(copy, s.data(), s.size());
+
+  this->NumBytes += s.size();
+
+  string_view view(copy, s.size());
+
+  this->Interned.insert(view);
+
+  return view;
+}
+
+
+//
+// size
+//
+size_t StringPool::size() const
+{
+  return this->Interned.size();
+}
+
+
+//
+// getNumBytes
+//
+size_t StringPool::getNumBytes() const
+{
+  return this->NumBytes;
+}
+
+
+//
+// getArena
+//
+Arena* StringPool::getArena() const
+{
+  return this->Memory.get();
+}
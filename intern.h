@@ -0,0 +1,73 @@
+/*intern.h*/
+
+/**
+  * @brief pool of interned strings.
+  *
+  * The text of the map (names, addresses, amenity types) is stored
+  * here once per distinct string, back to back in an Arena, and
+  * handed out as string_views. A string that occurs many times
+  * (the same street address, an empty address, a common type) is
+  * stored once, and no string is allocated on its own.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <string_view>
+#include <memory>
+#include <memory_resource>
+#include <unordered_set>
+
+#include "arena.h"
+
+using namespace std;
+
+
+/**
+  * @brief pool of interned strings.
+  *
+  * The views returned by intern( ) stay valid, and never move,
+  * until the pool is destroyed; the pool only grows. A pool may
+  * be shared by several collections (see Buildings and Amenities),
+  * which also allocate their indexes from its arena; it is not
+  * thread-safe: add strings from one thread at a time.
+  */
+class StringPool
+{
+public:
+/**
+  * @brief creates an empty pool.
+  *
+  * @param arena Where to store the strings, a new arena by default.
+  */
+  explicit StringPool(shared_ptr<Arena> arena = make_shared<Arena>());
+
+  // the pool is used in place (see getArena), so it's neither
+  // copied nor moved:
+  StringPool(const StringPool& other) = delete;
+  StringPool& operator=(const StringPool& other) = delete;
+
+/**
+  * @brief the pool's copy of the given string, added if it's not
+  * already in the pool.
+  *
+  * @param s The string.
+  * @return a view of the pool's copy.
+  */
+  string_view intern(string_view s);
+
+  // the # of distinct strings, and the # of bytes they take:
+  size_t size() const;
+  size_t getNumBytes() const;
+
+  // the arena the strings are in, which lives as long as the pool:
+  Arena* getArena() const;
+
+private:
+  shared_ptr<Arena> Memory;
+  size_t NumBytes;
+
+  pmr::unordered_set<string_view> Interned;  // also in the arena
+};
@@ -7,19 +7,41 @@
   * from an Open Street Map file. User can search for buildings
   * and nearby amenities.
   *
+  * Usage: ./a.out                  interactive; besides b, a and f,
+  *                                 "w building" finds the nearest
+  *                                 fast food by walking distance, and
+  *                                 "i building" the amenities within
+  *                                 a 5, 10 and 15 minute walk
+  *        ./a.out --batch [file] [--threads N]
+  *                                 runs the queries in the file (or
+  *                                 standard input), one per line, on
+  *                                 N threads (default: 1 per core)
+  *        ./a.out --serve [address]
+  *                                 answers queries over HTTP, in JSON,
+  *                                 on a loopback port or "unix:path"
+  *                                 (default: 8211), see server.h
+  *
   * @note Written by Jay Rao
   * @note Starter code by Prof. Joe Hummel
   * @note Northwestern University
   */
 
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <algorithm>
+#include <thread>
 
 #include "buildings.h"
 #include "nodes.h"
 #include "amenities.h"
+#include "graph.h"
+#include "hierarchy.h"
 #include "osm.h"
 #include "dist.h"
+#include "snapshot.h"
+#include "query.h"
+#include "server.h"
 
 using namespace std;
 
@@ -42,39 +64,132 @@ string toLower2(string s)
   *
   * @return 0 denoting success
   */
-int main()
+int main(int argc, char* argv[])
 {
-  XMLDocument xmldoc;
-  
-  cout << "** NU open street map **" << endl;
-  cout << endl;
-  
-  string filename = "nu.osm";
-
   //
-  // 1. load XML-based map file 
+  // in batch mode, the results go to standard output, buffered, and
+  // everything else goes to standard error:
   //
-  if (!osmLoadMapFile(filename, xmldoc))
+  bool batch = (argc > 1 && string(argv[1]) == "--batch");
+  string queryFilename = "-";
+  int numQueryThreads = max(1, (int) thread::hardware_concurrency());
+
+  bool serve = (argc > 1 && string(argv[1]) == "--serve");
+  string serverAddress = (serve && argc > 2) ? argv[2] : "8211";
+
+  for (int i = 2; batch && i < argc; i++)
   {
-    // error message already output by function
-    return 0;
+    string arg = argv[i];
+
+    if (arg == "--threads" && i + 1 < argc) {
+      numQueryThreads = max(1, atoi(argv[++i]));
+    }
+    else {
+      queryFilename = arg;
+    }
   }
+
+  if (batch) {
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+  }
+
+  ostream& info = batch ? cerr : cout;
+
+  info << "** NU open street map **" << endl;
+  info << endl;
   
+  string filename = "nu.osm";
+
   //
-  // 2. create and read the nodes, which are the various known 
-  //    positions on the map:
+  // the buildings and amenities keep their text in one pool, so a
+  // string used by both (e.g. an address) is stored once, and their
+  // indexes in the pool's arena:
   //
-  Nodes nodes(xmldoc);
-  
+  shared_ptr<StringPool> strings = make_shared<StringPool>();
+
+  Nodes nodes;
+  Buildings buildings(strings);
+  Amenities amenities(strings);
+  Graph graph;
+  ContractionHierarchy hierarchy;
+
   //
-  // 3. create and read the university buildings:
+  // 1. if we have an up-to-date snapshot of a previous run's
+  //    parsing, load that instead of the XML:
   //
-  Buildings buildings(xmldoc);
-  
+  string snapFilename = filename + ".snap";
+
+  if (!snapshotLoad(snapFilename, filename, nodes, buildings, amenities, graph, hierarchy))
+  {
+    //
+    // 2. stream through the XML-based map file once, handing each
+    //    element to the nodes (the various known positions on the 
+    //    map), the university buildings, the amenities, and the 
+    //    walking graph (the footpaths and streets). The
+    //    file is memory-mapped and parsed in place, with the node
+    //    section split across one thread per core:
+    //
+    int numThreads = max(1, (int) thread::hardware_concurrency());
+
+    nodes.beginChunks(numThreads);
+
+    bool success = osmParallelStreamMappedFile(filename, numThreads,
+      [&](int chunk, const OsmElement& elem)
+      {
+        nodes.addToChunk(chunk, elem);
+      },
+      [&](const OsmElement& elem)
+      {
+        buildings.add(elem);
+        amenities.add(elem);
+        graph.add(elem);
+      }
+    );
+
+    if (!success)
+    {
+      // error message already output by function
+      return 0;
+    }
+
+    nodes.mergeChunks();
+    
+    //
+    // 3. all elements have been read, finish building the
+    //    collections and save a snapshot for next time (if the
+    //    snapshot can't be written, we just parse again next run):
+    //
+    buildings.finishLoading(nodes);
+    amenities.finishLoading(nodes);
+    graph.finishLoading(nodes);
+
+    //
+    // the walking queries search a contraction hierarchy of the
+    // graph, which takes longer to build than the rest, so it's
+    // saved in the snapshot, too:
+    //
+    hierarchy.build(graph);
+
+    snapshotSave(snapFilename, filename, nodes, buildings, amenities, graph, hierarchy);
+
+    //
+    // flag (once) any nodes that are referenced but not in the map;
+    // they were dropped, so the queries never look for them:
+    //
+    int numMissing = buildings.getNumMissingNodes() + amenities.getNumMissingNodes() + graph.getNumMissingNodes();
+
+    if (numMissing > 0) {
+      info << "**WARNING: " << numMissing << " node references not found in map, ignored" << endl;
+    }
+  }
+
   //
-  // 4. create and read the amenities:
+  // the walking queries need to know where the amenities join
+  // the graph:
   //
-  Amenities amenities(xmldoc);
+  amenities.setGraph(graph);
+  amenities.setHierarchy(hierarchy);
 
   int num_of_nodes = nodes.getNumOsmNodes();
   int num_of_buildings = size(buildings.osmBuildings);
@@ -82,15 +197,77 @@ int main()
   int num_of_amenities = size(amenities.osmAmenities);
 
   //
-  // 5. stats
+  // 4. stats
+  //
+  info << "# of nodes:     " << nodes.getNumOsmNodes() << endl;
+  info << "# of buildings: " << size(buildings.osmBuildings) << endl;
+  info << "# of amenity types: " << num_of_types << endl;
+  info << "# of amenities:     " << num_of_amenities << endl;
+
+  //
+  // 5a. batch mode: run the queries back to back, no prompts:
+  //
+  if (batch)
+  {
+    int numQueries = 0;
+    ifstream queryFile;
+
+    if (queryFilename != "-")
+    {
+      queryFile.open(queryFilename);
+
+      if (!queryFile.good()) {
+        cerr << "**ERROR: unable to open query file '" << queryFilename << "'" << endl;
+        return 0;
+      }
+    }
+
+    istream& queries = (queryFilename != "-") ? queryFile : cin;
+
+    //
+    // the map is only read from here on, so the queries can run
+    // in parallel; the results are still written in order:
+    //
+    if (numQueryThreads > 1)
+    {
+      QueryPool pool(nodes, buildings, amenities, numQueryThreads);
+
+      numQueries = pool.runQueries(queries, cout);
+    }
+    else
+    {
+      numQueries = runQueries(queries, nodes, buildings, amenities, cout);
+    }
+
+    cout.flush();
+
+    info << "** Done, " << numQueries << " queries **" << endl;
+
+    return 0;
+  }
+
+  //
+  // 5b. server mode: answer queries over HTTP until interrupted:
   //
-  cout << "# of nodes:     " << nodes.getNumOsmNodes() << endl;
-  cout << "# of buildings: " << size(buildings.osmBuildings) << endl;
-  cout << "# of amenity types: " << num_of_types << endl;
-  cout << "# of amenities:     " << num_of_amenities << endl;
+  if (serve)
+  {
+    QueryServer server(nodes, buildings, amenities);
+
+    if (!server.listen(serverAddress)) {
+      return 0;
+    }
+
+    info << "Listening on " << serverAddress << ", ctrl-C to stop" << endl;
+
+    server.run();
+
+    info << "** Done **" << endl;
+
+    return 0;
+  }
 
   //
-  // 6. Now let the user search for buildings and amenities:
+  // 5c. Now let the user search for buildings and amenities:
   //
   while (true)
   {
@@ -118,6 +295,16 @@ int main()
       amenities.findNearestFastFood(amenities, buildings, nodes, num_of_amenities, coordinates_list);      
     }
 
+    else if (cmd == "w") {
+      vector< pair < int, pair <double, double> > > coordinates_list = buildings.fast_food_search(buildings, nodes, num_of_buildings);
+      amenities.findNearestFastFoodWalking(buildings, nodes, coordinates_list);
+    }
+
+    else if (cmd == "i") {
+      vector< pair < int, pair <double, double> > > coordinates_list = buildings.fast_food_search(buildings, nodes, num_of_buildings);
+      amenities.findWithinWalking(buildings, nodes, coordinates_list);
+    }
+
     else {
       cout << "Unknown command, please try again" << endl; 
     }
@@ -0,0 +1,109 @@
+/*mappedfile.cpp*/
+
+/**
+  * @brief a read-only, memory-mapped view of a file.
+  *
+  * Maps a file into memory so it can be read in place, straight 
+  * from the page cache, without first copying it into a heap 
+  * buffer. Processes that map the same file share one physical 
+  * copy of its pages.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mappedfile.h"
+
+using namespace std;
+
+
+//
+// constructor / destructor
+//
+MappedFile::MappedFile()
+  : Data(nullptr), Size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  this->close();
+}
+
+
+//
+// open
+//
+// Maps the given file into memory, returning true if successful
+// and false if the file could not be opened or mapped.
+//
+bool MappedFile::open(string filename, bool sequential)
+{
+  this->close();
+
+  int fd = ::open(filename.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* addr = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  //
+  // the mapping stays valid after the file is closed:
+  //
+  ::close(fd);
+
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+
+  madvise(addr, (size_t) info.st_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+  this->Data = (const char*) addr;
+  this->Size = (size_t) info.st_size;
+
+  return true;
+}
+
+
+//
+// close
+//
+// Releases the mapping, if any.
+//
+void MappedFile::close()
+{
+  if (this->Data != nullptr) {
+    munmap((void*) this->Data, this->Size);
+  }
+
+  this->Data = nullptr;
+  this->Size = 0;
+}
+
+
+//
+// getters:
+//
+const char* MappedFile::getData()
+{ return this->Data; }
+
+size_t MappedFile::getSize()
+{ return this->Size; }
+
+bool MappedFile::isOpen()
+{ return this->Data != nullptr; }
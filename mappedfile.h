@@ -0,0 +1,62 @@
+/*mappedfile.h*/
+
+/**
+  * @brief a read-only, memory-mapped view of a file.
+  *
+  * Maps a file into memory so it can be read in place, straight 
+  * from the page cache, without first copying it into a heap 
+  * buffer. Processes that map the same file share one physical 
+  * copy of its pages.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+
+/**
+  * @brief a read-only, memory-mapped view of a file.
+  *
+  * The mapping is released when the object is destroyed, so a
+  * MappedFile cannot be copied.
+  */
+class MappedFile
+{
+private:
+  const char* Data;
+  size_t      Size;
+
+public:
+  // constructor / destructor
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+/**
+  * @brief maps the given file into memory.
+  *
+  * @param filename The file to map.
+  * @param sequential True if the file will be read front to back
+  *   (the kernel then reads ahead aggressively), false if it will
+  *   be accessed randomly.
+  * @return true if successful, false if the file could not be 
+  *   opened or mapped (e.g. it is empty or not a regular file).
+  */
+  bool open(string filename, bool sequential);
+
+  // releases the mapping, if any
+  void close();
+
+  // getters:
+  const char* getData();
+  size_t      getSize();
+  bool        isOpen();
+};
@@ -8,6 +8,9 @@
 // CS 211
 // 
 
+#include <limits>
+#include <algorithm>
+
 #include "node.h"
 
 using namespace std;
@@ -38,22 +41,22 @@ Node::Node(const Node& other)
 //
 // accessors / getters
 //
-long long Node::getID() {
+long long Node::getID() const {
 
   Node::CallsToGetID++;
 
   return this->ID;
 }
 
-double Node::getLat() {
+double Node::getLat() const {
   return this->Lat;
 }
 
-double Node::getLon() {
+double Node::getLon() const {
   return this->Lon;
 }
 
-bool Node::getIsEntrance() {
+bool Node::getIsEntrance() const {
   return this->IsEntrance;
 }
 
@@ -69,3 +72,49 @@ int Node::getCopied() {
   return Node::Copied;
 }
 
+
+
+//
+// NodeTable:
+//
+
+//
+// the average (lat, lon) of the given nodes, summed in the order
+// given; with no nodes, this is (nan, nan).
+//
+pair<double, double> NodeTable::getCentroid(span<const uint32_t> indices) const
+{
+  double lat_total = 0;
+  double lon_total = 0;
+  double length = 0;
+
+  for (uint32_t i : indices) {
+    lat_total += this->getLat(i);
+    lon_total += this->getLon(i);
+    length += 1;
+  }
+
+  return make_pair(lat_total / length, lon_total / length);
+}
+
+//
+// the bounding box of the given nodes:
+//
+BoundingBox NodeTable::getBounds(span<const uint32_t> indices) const
+{
+  double inf = numeric_limits<double>::infinity();
+
+  BoundingBox box = { inf, inf, -inf, -inf };
+
+  for (uint32_t i : indices) {
+    double lat = this->getLat(i);
+    double lon = this->getLon(i);
+
+    box.MinLat = min(box.MinLat, lat);
+    box.MinLon = min(box.MinLon, lon);
+    box.MaxLat = max(box.MaxLat, lat);
+    box.MaxLon = max(box.MaxLon, lon);
+  }
+
+  return box;
+}
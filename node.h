@@ -10,6 +10,102 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <span>
+#include <utility>
+
+using namespace std;
+
+//
+// NodeCoord:
+//
+// How the node table stores a latitude or longitude. By default
+// this is 32-bit fixed point in units of 1e-7 degrees, which is
+// the precision OSM itself stores, so coordinates read from a map
+// file round-trip exactly. Compile with -DNODES_DOUBLE_COORDS to
+// store them as doubles instead.
+//
+#ifndef NODES_DOUBLE_COORDS
+typedef int32_t NodeCoord;
+
+inline NodeCoord toNodeCoord(double degrees)
+{ return (NodeCoord) llround(degrees * 1e7); }
+
+inline double fromNodeCoord(NodeCoord coord)
+{ return coord / 1e7; }
+#else
+typedef double NodeCoord;
+
+inline NodeCoord toNodeCoord(double degrees)
+{ return degrees; }
+
+inline double fromNodeCoord(NodeCoord coord)
+{ return coord; }
+#endif
+
+//
+// NodeRecord:
+//
+// A node as it's read from the map file, before it's stored in
+// the Nodes collection's node table.
+//
+struct NodeRecord
+{
+  long long ID;
+  double    Lat;
+  double    Lon;
+  bool      IsEntrance;
+};
+
+//
+// BoundingBox:
+//
+// The smallest lat/lon box around a set of nodes. A box around no
+// nodes is empty (the mins are greater than the maxes).
+//
+struct BoundingBox
+{
+  double MinLat;
+  double MinLon;
+  double MaxLat;
+  double MaxLon;
+};
+
+//
+// NodeTable:
+//
+// Read-only view of the Nodes collection's node table, which is
+// stored as a structure of arrays sorted by id: the i'th node is
+// (IDs[i], Lats[i], Lons[i]), and is an entrance if bit i of the
+// Entrances bitset is set. Each array is contiguous, so a scan
+// over coordinates touches only coordinates.
+//
+struct NodeTable
+{
+  span<const long long> IDs;
+  span<const NodeCoord> Lats;
+  span<const NodeCoord> Lons;
+  span<const uint64_t>  Entrances;  // 1 bit per node
+
+  size_t size() const
+  { return IDs.size(); }
+
+  double getLat(size_t i) const
+  { return fromNodeCoord(Lats[i]); }
+
+  double getLon(size_t i) const
+  { return fromNodeCoord(Lons[i]); }
+
+  bool getIsEntrance(size_t i) const
+  { return (Entrances[i / 64] >> (i % 64)) & 1; }
+
+  // the average (lat, lon) and the bounding box of the given nodes:
+  pair<double, double> getCentroid(span<const uint32_t> indices) const;
+  BoundingBox getBounds(span<const uint32_t> indices) const;
+};
+
 //
 // Node:
 //
@@ -32,9 +128,9 @@ private:
   // many times getID( ) is called, how many nodes
   // are created, and how many are copied:
   //
-  inline static int CallsToGetID = 0;
-  inline static int Created = 0;
-  inline static int Copied = 0;
+  inline static atomic<int> CallsToGetID = 0;
+  inline static atomic<int> Created = 0;
+  inline static atomic<int> Copied = 0;
 
 public:
   //
@@ -50,10 +146,10 @@ public:
   //
   // accessors / getters
   //
-  long long getID();
-  double getLat();
-  double getLon();
-  bool getIsEntrance();
+  long long getID() const;
+  double getLat() const;
+  double getLon() const;
+  bool getIsEntrance() const;
 
   static int getCallsToGetID();
   static int getCreated();
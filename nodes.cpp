@@ -36,6 +36,14 @@ using namespace std;
 using namespace tinyxml2;
 
 
+//
+// default constructor
+//
+Nodes::Nodes()
+{
+  // vectors are default initialized by their constructors
+}
+
 //
 // constructor
 //
@@ -54,75 +62,305 @@ Nodes::Nodes(XMLDocument& xmldoc)
   // Parse the XML document node by node: 
   //
   XMLElement* node = osm->FirstChildElement("node");
+  OsmElement elem;
 
   while (node != nullptr)
   {
-    const XMLAttribute* attrId = node->FindAttribute("id");
-    const XMLAttribute* attrLat = node->FindAttribute("lat");
-    const XMLAttribute* attrLon = node->FindAttribute("lon");
-
-    assert(attrId != nullptr);
-    assert(attrLat != nullptr);
-    assert(attrLon != nullptr);
+    osmReadElement(node, elem);
 
-    long long id = attrId->Int64Value();
-    double latitude = attrLat->DoubleValue();
-    double longitude = attrLon->DoubleValue();
+    this->add(elem);
 
     //
-    // is this node an entrance? Check for a 
-    // standard entrance, the main entrance, or
-    // one-way entrance.
+    // next node element in the XML doc:
     //
-    bool entrance = false;
+    node = node->NextSiblingElement("node");
+  }
+
+  this->finishLoading();
+}
+
+//
+// isEntrance
+//
+// local helper: is this node an entrance? Check for a standard
+// entrance, the main entrance, or one-way entrance. Most nodes
+// have no tags at all, so this is usually no work.
+//
+static bool isEntrance(const OsmElement& elem)
+{
+  if (elem.getNumTags() == 0) {
+    return false;
+  }
+
+  string_view entrance = osmGetKeyValue(elem, "entrance");
+
+  return entrance == "yes" || entrance == "main" || entrance == "entrance";
+}
+
+//
+// add
+//
+// Given an element of the map, stores it if it's a node; ways
+// and relations are ignored.
+//
+void Nodes::add(const OsmElement& elem)
+{
+  if (elem.ElemKind != OsmElement::NODE) {
+    return;
+  }
+
+  NodeRecord N = { elem.ID, elem.Lat, elem.Lon, isEntrance(elem) };
+
+  this->Pending.push_back(N);
+}
+
+//
+// finishLoading
+//
+// Called once all nodes have been added: sorts the pending nodes
+// by id and appends them to the node table. OSM files list nodes 
+// in id order, so normally there's nothing to sort. If an id
+// appears twice, the first one wins.
+//
+void Nodes::finishLoading()
+{
+  //
+  // if the table already has nodes (e.g. add( ) was called after
+  // an earlier finishLoading( )), they go first, as they were
+  // added first:
+  //
+  if (this->Table.size() > 0)
+  {
+    vector<NodeRecord> all;
+
+    all.reserve(this->Table.size() + this->Pending.size());
+
+    for (size_t i = 0; i < this->Table.size(); i++) {
+      all.push_back(NodeRecord{ this->Table.IDs[i], this->Table.getLat(i),
+        this->Table.getLon(i), this->Table.getIsEntrance(i) });
+    }
 
-    if (osmContainsKeyValue(node, "entrance", "yes") ||
-      osmContainsKeyValue(node, "entrance", "main") ||
-      osmContainsKeyValue(node, "entrance", "entrance"))
+    all.insert(all.end(), this->Pending.begin(), this->Pending.end());
+
+    this->Pending.swap(all);
+  }
+
+  this->Mapped = nullptr;
+
+  bool sorted = is_sorted(this->Pending.begin(), this->Pending.end(),
+    [](const NodeRecord& n1, const NodeRecord& n2) -> bool
     {
-      entrance = true;
+      return n1.ID < n2.ID;
     }
+  );
 
-    //
-    // Add node to vector:
-    // 
-    // This creates an object then pushes copy into vector:
-    //
-    Node N(id, latitude, longitude, entrance);
-    this->osmNodes.emplace(id, Node(id, latitude, longitude, entrance));
+  if (!sorted)
+  {
+    stable_sort(this->Pending.begin(), this->Pending.end(),
+      [](const NodeRecord& n1, const NodeRecord& n2) -> bool
+      {
+        return n1.ID < n2.ID;
+      }
+    );
+  }
 
-    //
-    // next node element in the XML doc:
-    //
-    node = node->NextSiblingElement("node");
+  vector<NodeRecord>::iterator last_unique = unique(this->Pending.begin(), this->Pending.end(),
+    [](const NodeRecord& n1, const NodeRecord& n2) -> bool
+    {
+      return n1.ID == n2.ID;
+    }
+  );
+
+  this->Pending.erase(last_unique, this->Pending.end());
+
+  //
+  // now store as a structure of arrays:
+  //
+  size_t n = this->Pending.size();
+
+  this->osmIDs.resize(n);
+  this->osmLats.resize(n);
+  this->osmLons.resize(n);
+  this->osmEntrances.assign((n + 63) / 64, 0);
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const NodeRecord& N = this->Pending[i];
+
+    this->osmIDs[i] = N.ID;
+    this->osmLats[i] = toNodeCoord(N.Lat);
+    this->osmLons[i] = toNodeCoord(N.Lon);
+
+    if (N.IsEntrance) {
+      this->osmEntrances[i / 64] |= (uint64_t) 1 << (i % 64);
+    }
   }
+
+  this->osmIDs.shrink_to_fit();
+  this->osmLats.shrink_to_fit();
+  this->osmLons.shrink_to_fit();
+  this->osmEntrances.shrink_to_fit();
+
+  vector<NodeRecord>().swap(this->Pending);  // free the pending nodes
+
+  this->Table.IDs = this->osmIDs;
+  this->Table.Lats = this->osmLats;
+  this->Table.Lons = this->osmLons;
+  this->Table.Entrances = this->osmEntrances;
+}
+
+//
+// beginChunks
+//
+// Sets up one pending list of nodes per chunk, for loading
+// in parallel.
+//
+void Nodes::beginChunks(int numChunks)
+{
+  this->Chunks.clear();
+  this->Chunks.resize(numChunks);
+}
+
+//
+// addToChunk
+//
+// Stores the given node into the pending list of the given chunk;
+// each chunk has its own list, so different chunks can be added
+// to concurrently.
+//
+void Nodes::addToChunk(int chunk, const OsmElement& elem)
+{
+  if (elem.ElemKind != OsmElement::NODE) {
+    return;
+  }
+
+  NodeRecord N = { elem.ID, elem.Lat, elem.Lon, isEntrance(elem) };
+
+  this->Chunks[chunk].push_back(N);
+}
+
+//
+// mergeChunks
+//
+// Appends the pending nodes of every chunk to the node table, in
+// chunk (i.e. file) order, then finishes loading.
+//
+void Nodes::mergeChunks()
+{
+  size_t total = this->Pending.size();
+
+  for (vector<NodeRecord>& chunk : this->Chunks) {
+    total += chunk.size();
+  }
+
+  this->Pending.reserve(total);
+
+  for (vector<NodeRecord>& chunk : this->Chunks) {
+    this->Pending.insert(this->Pending.end(), chunk.begin(), chunk.end());
+  }
+
+  this->Chunks.clear();
+
+  this->finishLoading();
 }
 
 //
 // find
 // 
 // Searches the nodes for the one with the matching ID, returning
-// true if found and false if not. If found, a copy of the node 
-// is returned via the node parameter, which is passed by reference.
+// true if found and false if not. If found, the node's Lat, Lon,
+// and IsEntrance data are returned via the reference parameters.
+//
+bool Nodes::find(long long id, double& lat, double& lon, bool& isEntrance) const
+{
+  int i = this->findIndex(id);
+
+  if (i < 0) { // not found:
+    return false;
+  }
+
+  lat = this->Table.getLat(i);
+  lon = this->Table.getLon(i);
+  isEntrance = this->Table.getIsEntrance(i);
+  return true; 
+}
+
+//
+// findIndex
+//
+// Searches the nodes for the one with the matching ID, returning
+// its index in the node table, or -1 if not found.
+//
+// The ids are a flat array sorted by id, searched with a
+// branchless binary search: each step halves the range with a 
+// conditional move instead of a branch, so there are no branch
+// mispredictions and the loop runs a fixed log2(N) times.
 //
-bool Nodes::find(long long id, double& lat, double& lon, bool& isEntrance) 
+int Nodes::findIndex(long long id) const
 {
-  map<long long, Node>::iterator iter = this->osmNodes.find(id);
-  if (iter == this->osmNodes.end()) { // not found:
-    return false;  
+  const long long* ids = this->Table.IDs.data();
+  const long long* base = ids;
+  size_t n = this->Table.size();
+
+  if (n == 0) {
+    return -1;
+  }
+
+  while (n > 1)
+  {
+    size_t half = n / 2;
+
+    base = (base[half] <= id) ? base + half : base;
+    n -= half;
   }
-  else { // found:
-    lat = (*iter).second.getLat();
-    lon = (*iter).second.getLon();
-    isEntrance = (*iter).second.getIsEntrance();
-    return true; 
+
+  if (*base != id) { // not found:
+    return -1;
   }
+
+  return (int) (base - ids);
+}
+
+//
+// writeSnapshot
+//
+// Saves the node table to a snapshot; the snapshot stores the
+// same arrays, so it can be used in place when loaded.
+//
+void Nodes::writeSnapshot(SnapshotWriter& out)
+{
+  out.NodeIDs.assign(this->Table.IDs.begin(), this->Table.IDs.end());
+  out.NodeLats.assign(this->Table.Lats.begin(), this->Table.Lats.end());
+  out.NodeLons.assign(this->Table.Lons.begin(), this->Table.Lons.end());
+  out.NodeEntrances.assign(this->Table.Entrances.begin(), this->Table.Entrances.end());
+}
+
+//
+// readSnapshot
+//
+// Switches to using the node table of the given (mapped) 
+// snapshot in place; nothing is copied.
+//
+void Nodes::readSnapshot(shared_ptr<Snapshot> snapshot)
+{
+  this->osmIDs.clear();
+  this->osmLats.clear();
+  this->osmLons.clear();
+  this->osmEntrances.clear();
+  this->Pending.clear();
+
+  this->Mapped = snapshot;
+  this->Table = snapshot->getNodes();
 }
 
 //
 // accessors / getters
 //
-int Nodes::getNumOsmNodes() {
-  return (int) this->osmNodes.size();
+int Nodes::getNumOsmNodes() const {
+  return (int) this->Table.size();
+}
+
+NodeTable Nodes::getTable() const {
+  return this->Table;
 }
 
@@ -24,9 +24,13 @@
 
 #pragma once
 
-#include <map>
+#include <vector>
+#include <memory>
+#include <span>
 
 #include "node.h"
+#include "osm.h"
+#include "snapshot.h"
 #include "tinyxml2.h"
 
 using namespace std;
@@ -39,9 +43,51 @@ using namespace tinyxml2;
 class Nodes
 {
 private:
-  map<long long, Node> osmNodes;
+  //
+  // the nodes, stored as a structure of arrays sorted by id (see 
+  // NodeTable in node.h):
+  //
+  vector<long long> osmIDs;
+  vector<NodeCoord> osmLats;
+  vector<NodeCoord> osmLons;
+  vector<uint64_t>  osmEntrances;
+
+  //
+  // the node table that is searched: either the arrays above, or
+  // when loaded from a snapshot, the snapshot's node table in place:
+  //
+  NodeTable Table;
+  shared_ptr<Snapshot> Mapped;
+
+  //
+  // nodes added but not yet in the table; finishLoading( ) sorts
+  // them and moves them into the arrays:
+  //
+  vector<NodeRecord> Pending;
+
+  //
+  // when loaded in parallel, each chunk's nodes are collected
+  // separately and then merged in chunk order:
+  //
+  vector<vector<NodeRecord>> Chunks;
 
 public:
+  //
+  // default constructor
+  //
+  // Creates an empty collection, which is filled one element at
+  // a time by add( ) while streaming through the map file,
+  // followed by a call to finishLoading( ).
+  //
+  Nodes();
+
+  // the node table may refer to the collection's own arrays, so 
+  // it is movable but cannot be copied:
+  Nodes(const Nodes& other) = delete;
+  Nodes& operator=(const Nodes& other) = delete;
+  Nodes(Nodes&& other) = default;
+  Nodes& operator=(Nodes&& other) = default;
+
   //
   // constructor
   //
@@ -53,6 +99,37 @@ public:
   //
   Nodes(XMLDocument& xmldoc);
 
+  //
+  // add
+  //
+  // Given an element of the map, stores it if it's a node; ways
+  // and relations are ignored.
+  //
+  void add(const OsmElement& elem);
+
+  //
+  // finishLoading
+  //
+  // Called once all nodes have been added: sorts them by id (if
+  // the file wasn't already in id order) and builds the node 
+  // table so it can be searched.
+  //
+  void finishLoading();
+
+  //
+  // beginChunks / addToChunk / mergeChunks
+  //
+  // For loading with osmParallelStreamMappedFile: beginChunks sets
+  // up numChunks pending lists, addToChunk stores a node into the
+  // given chunk's list (safe to call concurrently for different 
+  // chunks), and mergeChunks moves all pending nodes into the
+  // collection once parsing is done (mergeChunks calls 
+  // finishLoading, so there's no need to call it again).
+  //
+  void beginChunks(int numChunks);
+  void addToChunk(int chunk, const OsmElement& elem);
+  void mergeChunks();
+
   //
   // find
   // 
@@ -60,12 +137,30 @@ public:
   // true if found and false if not. If found, the node's Lat, Lon,
   // and IsEntrance data are returned via the reference parameters.
   //
-  bool find(long long id, double& lat, double& lon, bool& isEntrance);
+  bool find(long long id, double& lat, double& lon, bool& isEntrance) const;
+
+  //
+  // findIndex
+  //
+  // Searches the nodes for the one with the matching ID, returning
+  // its (dense) index in the node table, or -1 if not found.
+  //
+  int findIndex(long long id) const;
+
+  //
+  // writeSnapshot / readSnapshot
+  //
+  // Saves the node table to a snapshot, or switches to using the
+  // node table of a (mapped) snapshot in place.
+  //
+  void writeSnapshot(SnapshotWriter& out);
+  void readSnapshot(shared_ptr<Snapshot> snapshot);
 
   //
   // accessors / getters
   //
-  int getNumOsmNodes();
+  int getNumOsmNodes() const;
+  NodeTable getTable() const;  // read-only view of the node table
 
 };
 
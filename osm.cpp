@@ -23,10 +23,16 @@
 //
 
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <thread>
+#include <string_view>
+#include <cstring>
+#include <charconv>
 #include <cassert>
 
 #include "osm.h"
+#include "mappedfile.h"
 
 using namespace std;
 using namespace tinyxml2;
@@ -74,6 +80,800 @@ bool osmLoadMapFile(string filename, XMLDocument& xmldoc)
 }
 
 
+//
+// OsmElement::clear
+//
+// Resets the element so it can be reused for the next one read;
+// the vectors and the tag text keep their capacity, so a reader 
+// that reuses one element does not allocate per element.
+//
+void OsmElement::clear()
+{
+  this->ElemKind = NODE;
+  this->ID = 0;
+  this->Lat = 0.0;
+  this->Lon = 0.0;
+  this->Refs.clear();
+  this->TagText.clear();
+  this->TagEnds.clear();
+}
+
+
+//
+// OsmElement tags:
+//
+size_t OsmElement::getNumTags() const
+{
+  return this->TagEnds.size();
+}
+
+string_view OsmElement::getTagKey(size_t i) const
+{
+  uint32_t start = (i == 0) ? 0 : this->TagEnds[i - 1].second;
+
+  return string_view(this->TagText).substr(start, this->TagEnds[i].first - start);
+}
+
+string_view OsmElement::getTagValue(size_t i) const
+{
+  uint32_t start = this->TagEnds[i].first;
+
+  return string_view(this->TagText).substr(start, this->TagEnds[i].second - start);
+}
+
+void OsmElement::addTag(string_view key, string_view value)
+{
+  this->TagText.append(key);
+  uint32_t keyEnd = (uint32_t) this->TagText.size();
+
+  this->TagText.append(value);
+  this->TagEnds.push_back(make_pair(keyEnd, (uint32_t) this->TagText.size()));
+}
+
+
+//
+// local helper functions for the streaming reader:
+//
+
+//
+// decodes the XML entities (&amp; &lt; &gt; &quot; &apos; and 
+// numeric &#...; references) in the raw attribute value s,
+// storing the result in out:
+//
+static void decodeEntities(string_view s, string& out)
+{
+  out.clear();
+
+  size_t amp = s.find('&');
+
+  if (amp == string_view::npos) {  // common case, nothing to decode:
+    out.assign(s.data(), s.size());
+    return;
+  }
+
+  size_t i = 0;
+
+  while (i < s.size())
+  {
+    if (s[i] != '&') {
+      out.push_back(s[i]);
+      i++;
+      continue;
+    }
+
+    size_t semi = s.find(';', i);
+
+    if (semi == string_view::npos) {  // not an entity, copy as is:
+      out.append(s.data() + i, s.size() - i);
+      break;
+    }
+
+    string_view entity = s.substr(i + 1, semi - i - 1);
+
+    if (entity == "amp") out.push_back('&');
+    else if (entity == "lt") out.push_back('<');
+    else if (entity == "gt") out.push_back('>');
+    else if (entity == "quot") out.push_back('"');
+    else if (entity == "apos") out.push_back('\'');
+    else if (entity.size() > 1 && entity[0] == '#')
+    {
+      unsigned long code = 0;
+      const char* first = entity.data() + 1;
+      int base = 10;
+
+      if (*first == 'x' || *first == 'X') {
+        first++;
+        base = 16;
+      }
+
+      from_chars(first, entity.data() + entity.size(), code, base);
+
+      //
+      // encode the code point as UTF-8:
+      //
+      if (code < 0x80) {
+        out.push_back((char) code);
+      }
+      else if (code < 0x800) {
+        out.push_back((char) (0xC0 | (code >> 6)));
+        out.push_back((char) (0x80 | (code & 0x3F)));
+      }
+      else if (code < 0x10000) {
+        out.push_back((char) (0xE0 | (code >> 12)));
+        out.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+        out.push_back((char) (0x80 | (code & 0x3F)));
+      }
+      else {
+        out.push_back((char) (0xF0 | (code >> 18)));
+        out.push_back((char) (0x80 | ((code >> 12) & 0x3F)));
+        out.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+        out.push_back((char) (0x80 | (code & 0x3F)));
+      }
+    }
+    else {  // unknown entity, copy as is:
+      out.append(s.data() + i, semi - i + 1);
+    }
+
+    i = semi + 1;
+  }
+}
+
+//
+// given a pointer to the '<' that starts a piece of markup, returns
+// a pointer to the '>' that ends it, or nullptr if the markup is
+// not complete in [lt, end):
+//
+static const char* findMarkupEnd(const char* lt, const char* end)
+{
+  string_view rest(lt, end - lt);
+
+  if (rest.size() < 2) {
+    return nullptr;
+  }
+
+  size_t pos = string_view::npos;
+
+  if (rest[1] == '?') {
+    pos = rest.find("?>", 2);
+    return (pos == string_view::npos) ? nullptr : lt + pos + 1;
+  }
+  else if (rest[1] == '!') {
+    if (rest.size() < 9) {  // can't tell comment / CDATA / DOCTYPE yet:
+      return nullptr;
+    }
+
+    if (rest.substr(0, 4) == "<!--") {
+      pos = rest.find("-->", 4);
+      return (pos == string_view::npos) ? nullptr : lt + pos + 2;
+    }
+    else if (rest.substr(0, 9) == "<![CDATA[") {
+      pos = rest.find("]]>", 9);
+      return (pos == string_view::npos) ? nullptr : lt + pos + 2;
+    }
+    else {
+      pos = rest.find('>', 2);
+      return (pos == string_view::npos) ? nullptr : lt + pos;
+    }
+  }
+
+  //
+  // ordinary start / end tag, where a '>' inside a quoted
+  // attribute value does not end the tag:
+  //
+  char quote = 0;
+
+  for (const char* p = lt + 1; p < end; p++)
+  {
+    if (quote != 0) {
+      if (*p == quote) quote = 0;
+    }
+    else if (*p == '"' || *p == '\'') {
+      quote = *p;
+    }
+    else if (*p == '>') {
+      return p;
+    }
+  }
+
+  return nullptr;
+}
+
+//
+// parses the next attribute name="value" in [p, end), advancing p
+// past it. Returns false when there are no more attributes:
+//
+static bool nextAttribute(const char*& p, const char* end, string_view& name, string_view& value)
+{
+  while (p < end && isspace((unsigned char) *p)) p++;
+
+  const char* nameStart = p;
+
+  while (p < end && *p != '=' && !isspace((unsigned char) *p)) p++;
+
+  if (p == nameStart) {
+    return false;
+  }
+
+  name = string_view(nameStart, p - nameStart);
+
+  while (p < end && *p != '"' && *p != '\'') p++;
+
+  if (p == end) {
+    return false;
+  }
+
+  char quote = *p;
+  p++;
+
+  const char* valueStart = p;
+
+  while (p < end && *p != quote) p++;
+
+  value = string_view(valueStart, p - valueStart);
+
+  if (p < end) p++;  // skip closing quote
+
+  return true;
+}
+
+
+//
+// OsmReader constructor
+//
+OsmReader::OsmReader(function<void(const OsmElement&)> visit, bool fragment)
+  : Visit(visit), Depth(0), InElement(false), SawOsm(false), Failed(false)
+{
+  if (fragment) {  // already inside <osm>:
+    this->Depth = 1;
+    this->SawOsm = true;
+  }
+}
+
+//
+// startTag
+//
+// Handles a start tag <name attrs> or <name attrs/>, where
+// [p, end) is the text between '<' and '>'.
+//
+void OsmReader::startTag(const char* p, const char* end)
+{
+  bool selfClosing = (end > p && end[-1] == '/');
+
+  if (selfClosing) {
+    end--;
+  }
+
+  const char* nameStart = p;
+
+  while (p < end && !isspace((unsigned char) *p)) p++;
+
+  string_view name(nameStart, p - nameStart);
+
+  //
+  // the document element must be <osm>:
+  //
+  if (this->Depth == 0)
+  {
+    if (name != "osm") {
+      this->Failed = true;
+      return;
+    }
+
+    this->SawOsm = true;
+
+    if (!selfClosing) {
+      this->Depth = 1;
+    }
+    return;
+  }
+
+  string_view attrName, attrValue;
+
+  if (this->Depth == 1 && (name == "node" || name == "way" || name == "relation"))
+  {
+    this->Current.clear();
+
+    if (name == "node") this->Current.ElemKind = OsmElement::NODE;
+    else if (name == "way") this->Current.ElemKind = OsmElement::WAY;
+    else this->Current.ElemKind = OsmElement::RELATION;
+
+    while (nextAttribute(p, end, attrName, attrValue))
+    {
+      const char* first = attrValue.data();
+      const char* last = first + attrValue.size();
+
+      if (attrName == "id") from_chars(first, last, this->Current.ID);
+      else if (attrName == "lat") from_chars(first, last, this->Current.Lat);
+      else if (attrName == "lon") from_chars(first, last, this->Current.Lon);
+    }
+
+    if (selfClosing) {  // element is complete:
+      this->Visit(this->Current);
+    }
+    else {
+      this->InElement = true;
+      this->Depth = 2;
+    }
+    return;
+  }
+
+  if (this->Depth == 2 && this->InElement)
+  {
+    if (name == "tag")
+    {
+      string_view k, v;
+
+      while (nextAttribute(p, end, attrName, attrValue))
+      {
+        if (attrName == "k") k = attrValue;
+        else if (attrName == "v") v = attrValue;
+      }
+
+      decodeEntities(k, this->Key);
+      decodeEntities(v, this->Value);
+
+      this->Current.addTag(this->Key, this->Value);
+    }
+    else if (name == "nd")
+    {
+      while (nextAttribute(p, end, attrName, attrValue))
+      {
+        if (attrName == "ref") {
+          long long ref = 0;
+          from_chars(attrValue.data(), attrValue.data() + attrValue.size(), ref);
+          this->Current.Refs.push_back(ref);
+        }
+      }
+    }
+  }
+
+  if (!selfClosing) {
+    this->Depth++;
+  }
+}
+
+//
+// endTag
+//
+// Handles an end tag </name>; a top-level element is handed to
+// the visit function once its end tag is seen.
+//
+void OsmReader::endTag(const char* p, const char* end)
+{
+  this->Depth--;
+
+  if (this->Depth < 0) {
+    this->Failed = true;
+    return;
+  }
+
+  if (this->Depth == 1 && this->InElement)
+  {
+    this->InElement = false;
+    this->Visit(this->Current);
+  }
+}
+
+//
+// feed
+//
+// Parses as much of [data, data+len) as possible, returning the
+// # of bytes consumed. Anything not consumed is an incomplete
+// piece of markup, which must be passed again at the front of
+// the next chunk.
+//
+size_t OsmReader::feed(const char* data, size_t len)
+{
+  const char* p = data;
+  const char* end = data + len;
+
+  while (p < end && !this->Failed)
+  {
+    const char* lt = (const char*) memchr(p, '<', end - p);
+
+    if (lt == nullptr) {  // only text left:
+      return len;
+    }
+
+    const char* gt = findMarkupEnd(lt, end);
+
+    if (gt == nullptr) {  // rest of markup is in the next chunk:
+      return lt - data;
+    }
+
+    if (lt[1] == '/') {
+      endTag(lt + 2, gt);
+    }
+    else if (lt[1] != '?' && lt[1] != '!') {
+      startTag(lt + 1, gt);
+    }
+
+    p = gt + 1;
+  }
+
+  return p - data;
+}
+
+//
+// accessors / getters
+//
+bool OsmReader::sawOsm() {
+  return this->SawOsm;
+}
+
+bool OsmReader::failed() {
+  return this->Failed;
+}
+
+
+//
+// osmStreamMapFile
+//
+// Given the filename of an open street map, reads through the
+// file a chunk at a time and calls visit for each top-level
+// <node>, <way> and <relation>, in file order. Unlike 
+// osmLoadMapFile, the document is never held in memory, so
+// memory use does not grow with the size of the file. Returns
+// true if successful, false if the file could not be opened 
+// OR the file does not contain an Open Street Map document.
+//
+bool osmStreamMapFile(string filename, function<void(const OsmElement&)> visit)
+{
+  ifstream file(filename, ios::binary);
+
+  if (!file.good())
+  {
+    cout << "**ERROR: unable to open XML file '" << filename << "'." << endl;
+    return false;
+  }
+
+  OsmReader reader(visit);
+
+  vector<char> buffer(1 << 20);  // 1 MB chunks
+  size_t kept = 0;               // bytes carried over from last chunk
+
+  while (true)
+  {
+    file.read(buffer.data() + kept, buffer.size() - kept);
+    size_t n = (size_t) file.gcount();
+
+    if (n == 0) {  // end of file:
+      break;
+    }
+
+    size_t total = kept + n;
+    size_t consumed = reader.feed(buffer.data(), total);
+
+    if (reader.failed()) {
+      break;
+    }
+
+    kept = total - consumed;
+    memmove(buffer.data(), buffer.data() + consumed, kept);
+
+    if (kept == buffer.size()) {  // one piece of markup larger than the buffer:
+      buffer.resize(buffer.size() * 2);
+    }
+  }
+
+  //
+  // bytes still kept at the end are a piece of markup the file cut
+  // off, which osmStreamMappedFile rejects too:
+  //
+  if (!reader.sawOsm() || reader.failed() || kept > 0)
+  {
+    cout << "**ERROR: unable to find top-level 'osm' XML element." << endl;
+    cout << "**ERROR: this file is probably not an Open Street Map." << endl;
+    return false;
+  }
+
+  //
+  // success:
+  //
+  return true;
+}
+
+
+//
+// osmStreamMappedFile
+//
+// Same as osmStreamMapFile, but the file is memory-mapped and
+// parsed directly from the mapped pages, avoiding the copy into
+// a read buffer; the pages live in the page cache, so multiple
+// processes reading the same map share them. If the file cannot
+// be mapped (e.g. it's a pipe), falls back to osmStreamMapFile.
+//
+bool osmStreamMappedFile(string filename, function<void(const OsmElement&)> visit)
+{
+  MappedFile file;
+
+  if (!file.open(filename, true /*sequential*/)) {
+    return osmStreamMapFile(filename, visit);
+  }
+
+  OsmReader reader(visit);
+
+  size_t consumed = reader.feed(file.getData(), file.getSize());
+
+  if (!reader.sawOsm() || reader.failed() || consumed != file.getSize())
+  {
+    cout << "**ERROR: unable to find top-level 'osm' XML element." << endl;
+    cout << "**ERROR: this file is probably not an Open Street Map." << endl;
+    return false;
+  }
+
+  //
+  // success:
+  //
+  return true;
+}
+
+
+//
+// findElementStart
+//
+// Returns a pointer to the next "<name" start tag in [p, end), or
+// end if there is none. A '<' cannot appear unescaped inside an
+// attribute value, so this is always the start of markup.
+//
+static const char* findElementStart(const char* p, const char* end, string_view name)
+{
+  while (p < end)
+  {
+    const char* lt = (const char*) memchr(p, '<', end - p);
+
+    if (lt == nullptr) {
+      return end;
+    }
+
+    const char* after = lt + 1 + name.size();
+
+    if (after < end && string_view(lt + 1, name.size()) == name &&
+      (isspace((unsigned char) *after) || *after == '>' || *after == '/'))
+    {
+      return lt;
+    }
+
+    p = lt + 1;
+  }
+
+  return end;
+}
+
+
+//
+// osmParallelStreamMappedFile
+//
+// Like osmStreamMappedFile, but the <node> section of the file, 
+// which holds nearly all of its elements, is parsed in parallel:
+// it's split into numThreads chunks on <node> boundaries and each
+// chunk is parsed by its own thread. 
+//
+// Every node is handed to visitNode(chunk, elem): those in the node
+// section on the thread that parsed them, so visitNode must be safe
+// to call concurrently for different chunks; chunks are numbered
+// 0..numThreads-1 in file order. Any node after the node section
+// (valid, if unusual) is handed to visitNode(numThreads-1, elem),
+// the last chunk in file order, on the calling thread once the
+// chunks are done. Nodes with tags (the only ones that can be
+// buildings or amenities), and then all ways and relations, are
+// also handed to visit, on the calling thread and in file order.
+//
+bool osmParallelStreamMappedFile(string filename, int numThreads,
+  function<void(int chunk, const OsmElement&)> visitNode,
+  function<void(const OsmElement&)> visit)
+{
+  if (numThreads < 1) {
+    numThreads = 1;
+  }
+
+  //
+  // a node outside the parallel node section is handed to visitNode
+  // as part of the last chunk, and on to visit only if it has tags:
+  //
+  auto visitInOrder = [&](const OsmElement& elem)
+  {
+    if (elem.ElemKind == OsmElement::NODE) {
+      visitNode(numThreads - 1, elem);
+
+      if (elem.getNumTags() == 0) return;
+    }
+
+    visit(elem);
+  };
+
+  MappedFile file;
+
+  if (!file.open(filename, true /*sequential*/))
+  {
+    //
+    // can't map, so read sequentially as a single chunk:
+    //
+    return osmStreamMapFile(filename, visitInOrder);
+  }
+
+  const char* data = file.getData();
+  const char* end = data + file.getSize();
+
+  //
+  // the node section runs from the first <node> to the first
+  // way, relation or the end of the document:
+  //
+  const char* nodesBegin = findElementStart(data, end, "node");
+  const char* nodesEnd = min(findElementStart(nodesBegin, end, "way"),
+    min(findElementStart(nodesBegin, end, "relation"),
+      findElementStart(nodesBegin, end, "/osm")));
+
+  //
+  // split the node section into chunks of roughly equal size, 
+  // moving each split point forward to the next <node>:
+  //
+  vector<const char*> bounds(numThreads + 1);
+
+  bounds[0] = nodesBegin;
+  bounds[numThreads] = nodesEnd;
+
+  for (int i = 1; i < numThreads; i++)
+  {
+    const char* approx = nodesBegin + (nodesEnd - nodesBegin) * i / numThreads;
+
+    bounds[i] = findElementStart(max(approx, bounds[i - 1]), nodesEnd, "node");
+  }
+
+  //
+  // parse the chunks, one thread each (the calling thread takes
+  // the first chunk). Tagged nodes are copied out so they can be
+  // passed to visit in order once all threads are done:
+  //
+  vector<vector<OsmElement>> tagged(numThreads);
+  vector<char> failed(numThreads, 0);
+
+  auto parseChunk = [&](int chunk)
+  {
+    OsmReader reader(
+      [&](const OsmElement& elem)
+      {
+        if (elem.ElemKind != OsmElement::NODE) {  // not in a node section:
+          failed[chunk] = 1;
+          return;
+        }
+
+        visitNode(chunk, elem);
+
+        if (elem.getNumTags() > 0) {
+          tagged[chunk].push_back(elem);
+        }
+      },
+      true /*fragment*/
+    );
+
+    size_t size = bounds[chunk + 1] - bounds[chunk];
+
+    if (reader.feed(bounds[chunk], size) != size || reader.failed()) {
+      failed[chunk] = 1;
+    }
+  };
+
+  vector<thread> workers;
+
+  for (int i = 1; i < numThreads; i++) {
+    workers.push_back(thread(parseChunk, i));
+  }
+
+  parseChunk(0);
+
+  for (thread& t : workers) {
+    t.join();
+  }
+
+  //
+  // now the rest of the file, in order: what comes before the
+  // nodes (<osm> itself), the tagged nodes, and then the ways
+  // and relations (and any nodes among them):
+  //
+  OsmReader reader(visitInOrder);
+
+  size_t prefix = nodesBegin - data;
+  bool ok = (reader.feed(data, prefix) == prefix) && !reader.failed();
+
+  //
+  // the nodes are only parsed as such if the file did start with
+  // <osm>, so that's checked first:
+  //
+  if (!ok || (!reader.sawOsm() && nodesBegin != end))
+  {
+    cout << "**ERROR: unable to find top-level 'osm' XML element." << endl;
+    cout << "**ERROR: this file is probably not an Open Street Map." << endl;
+    return false;
+  }
+
+  for (int i = 0; i < numThreads; i++)
+  {
+    if (failed[i])
+    {
+      cout << "**ERROR: malformed XML among the nodes of '" << filename << "'." << endl;
+      return false;
+    }
+  }
+
+  for (int i = 0; i < numThreads; i++)
+  {
+    for (const OsmElement& elem : tagged[i]) {
+      visit(elem);
+    }
+  }
+
+  size_t suffix = end - nodesEnd;
+
+  ok = (reader.feed(nodesEnd, suffix) == suffix);
+
+  if (!reader.sawOsm())
+  {
+    cout << "**ERROR: unable to find top-level 'osm' XML element." << endl;
+    cout << "**ERROR: this file is probably not an Open Street Map." << endl;
+    return false;
+  }
+
+  if (!ok || reader.failed())
+  {
+    cout << "**ERROR: malformed XML after the nodes of '" << filename << "'." << endl;
+    return false;
+  }
+
+  //
+  // success:
+  //
+  return true;
+}
+
+
+//
+// osmReadElement
+//
+// Given a pointer to a top-level <node>, <way> or <relation> in
+// an XML document, copies its id, position, tags and node refs
+// into elem, so that documents loaded with osmLoadMapFile can be
+// handled the same way as streamed ones.
+//
+void osmReadElement(XMLElement* e, OsmElement& elem)
+{
+  elem.clear();
+
+  string name(e->Value());
+
+  if (name == "node") elem.ElemKind = OsmElement::NODE;
+  else if (name == "way") elem.ElemKind = OsmElement::WAY;
+  else elem.ElemKind = OsmElement::RELATION;
+
+  elem.ID = e->Int64Attribute("id");
+  elem.Lat = e->DoubleAttribute("lat");
+  elem.Lon = e->DoubleAttribute("lon");
+
+  XMLElement* tag = e->FirstChildElement("tag");
+
+  while (tag != nullptr)
+  {
+    const char* k = tag->Attribute("k");
+    const char* v = tag->Attribute("v");
+
+    if (k != nullptr && v != nullptr) {
+      elem.addTag(k, v);
+    }
+
+    tag = tag->NextSiblingElement("tag");
+  }
+
+  XMLElement* nd = e->FirstChildElement("nd");
+
+  while (nd != nullptr)
+  {
+    elem.Refs.push_back(nd->Int64Attribute("ref"));
+
+    nd = nd->NextSiblingElement("nd");
+  }
+}
+
+
 //
 // osmContainsKeyValue
 //
@@ -87,7 +887,7 @@ bool osmLoadMapFile(string filename, XMLDocument& xmldoc)
 //
 //   <tag k="entrance" v="yes"/>
 //
-bool osmContainsKeyValue(XMLElement* e, string key, string value)
+bool osmContainsKeyValue(XMLElement* e, string_view key, string_view value)
 {
   XMLElement* tag = e->FirstChildElement("tag");
 
@@ -98,10 +898,7 @@ bool osmContainsKeyValue(XMLElement* e, string key, string value)
 
     if (keyAttribute != nullptr && valueAttribute != nullptr)
     {
-      string elemkey(keyAttribute->Value());
-      string elemvalue(valueAttribute->Value());
-
-      if (elemkey == key && elemvalue == value)  // found it:
+      if (keyAttribute->Value() == key && valueAttribute->Value() == value)  // found it:
       {
         return true;
       }
@@ -135,8 +932,10 @@ bool osmContainsKeyValue(XMLElement* e, string key, string value)
 //   <tag k="entrance" v="yes"/>
 // 
 // If the key is not found, the empty string "" is returned.
+// The value is a view of the XML document's copy, valid as long
+// as the document.
 //
-string osmGetKeyValue(XMLElement* e, string key)
+string_view osmGetKeyValue(XMLElement* e, string_view key)
 {
   XMLElement* tag = e->FirstChildElement("tag");
 
@@ -147,13 +946,9 @@ string osmGetKeyValue(XMLElement* e, string key)
 
     if (keyAttribute != nullptr && valueAttribute != nullptr)
     {
-      string elemkey(keyAttribute->Value());
-      
-      if (elemkey == key)  // found it:
+      if (keyAttribute->Value() == key)  // found it:
       {
-        string elemvalue(valueAttribute->Value());
-
-        return elemvalue;
+        return valueAttribute->Value();
       }
     }
 
@@ -168,3 +963,97 @@ string osmGetKeyValue(XMLElement* e, string key)
   //
   return "";
 }
+
+
+//
+// osmContainsKeyValue
+//
+// Same as above, but for an element produced by the streaming
+// reader.
+//
+bool osmContainsKeyValue(const OsmElement& e, string_view key, string_view value)
+{
+  for (size_t i = 0; i < e.getNumTags(); i++)
+  {
+    if (e.getTagKey(i) == key && e.getTagValue(i) == value) {  // found it:
+      return true;
+    }
+  }
+
+  //
+  // if get here, not found:
+  //
+  return false;
+}
+
+
+//
+// osmGetKeyValue
+//
+// Same as above, but for an element produced by the streaming
+// reader. If the key is not found, the empty string "" is 
+// returned. The value is a view into the element, valid until
+// the element changes.
+//
+string_view osmGetKeyValue(const OsmElement& e, string_view key)
+{
+  for (size_t i = 0; i < e.getNumTags(); i++)
+  {
+    if (e.getTagKey(i) == key) {  // found it:
+      return e.getTagValue(i);
+    }
+  }
+
+  //
+  // if get here, not found:
+  //
+  return "";
+}
+
+
+//
+// osmGetKeyValues
+//
+// Looks up several keys in one pass over the element's tags:
+// values[i] is set to the value of keys[i] (the first tag with
+// that key), or "" if there is no such tag. For example,
+//
+//   string_view keys[] = { "name", "addr:street" };
+//   string_view values[2];
+//   osmGetKeyValues(elem, keys, values);
+//
+// Returns the # of keys found. The values are views into the
+// element, valid until the element changes.
+//
+int osmGetKeyValues(const OsmElement& e, span<const string_view> keys, span<string_view> values)
+{
+  size_t n = min(keys.size(), values.size());
+  size_t found = 0;
+
+  for (size_t k = 0; k < n; k++) {
+    values[k] = string_view();  // null until found
+  }
+
+  for (size_t i = 0; i < e.getNumTags() && found < n; i++)
+  {
+    string_view key = e.getTagKey(i);
+
+    for (size_t k = 0; k < n; k++)
+    {
+      if (values[k].data() == nullptr && key == keys[k])
+      {
+        values[k] = e.getTagValue(i);
+        found++;
+        break;
+      }
+    }
+  }
+
+  for (size_t k = 0; k < n; k++) {
+    if (values[k].data() == nullptr) {
+      values[k] = "";
+    }
+  }
+
+  return (int) found;
+}
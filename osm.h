@@ -24,15 +24,120 @@
 
 #pragma once
 
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <utility>
+#include <functional>
+
 #include "tinyxml2.h"
 
 using namespace std;
 using namespace tinyxml2;
 
 
+//
+// OsmElement:
+//
+// One top-level element of the map (a <node>, <way> or <relation>)
+// with its id, position (nodes only), tags, and the ids of the
+// nodes it refers to (ways only). This is what the streaming
+// reader hands out, one element at a time.
+//
+// The text of all the tags is kept back to back in one buffer, so
+// an element that is cleared and reused (as the reader does) stops
+// allocating once its buffer is big enough; the keys and values 
+// are string_views into the buffer, valid until the element is
+// changed.
+//
+struct OsmElement
+{
+  enum Kind { NODE, WAY, RELATION };
+
+  Kind      ElemKind = NODE;
+  long long ID = 0;
+  double    Lat = 0.0;
+  double    Lon = 0.0;
+  vector<long long> Refs;  // <nd ref="..."/> of a way
+
+  // the tags, (k, v) pairs, in order:
+  size_t getNumTags() const;
+  string_view getTagKey(size_t i) const;
+  string_view getTagValue(size_t i) const;
+  void addTag(string_view key, string_view value);
+
+  void clear();
+
+private:
+  string TagText;
+  vector<pair<uint32_t, uint32_t>> TagEnds;  // end of (key, value) in TagText
+};
+
+//
+// OsmReader:
+//
+// Streaming (SAX-style) reader for an open street map file. The
+// file is fed in as a sequence of chunks, and each complete
+// top-level <node>, <way> or <relation> is passed to the visit
+// function as soon as its closing tag is seen. Only the element
+// currently being read is kept in memory, never the whole document.
+//
+class OsmReader
+{
+private:
+  function<void(const OsmElement&)> Visit;
+  OsmElement Current;
+  string Key, Value;  // the tag being read, decoded
+  int  Depth;       // nesting depth of the markup seen so far
+  bool InElement;   // inside a top-level node/way/relation?
+  bool SawOsm;      // seen the top-level <osm> element?
+  bool Failed;
+
+  void startTag(const char* p, const char* end);
+  void endTag(const char* p, const char* end);
+
+public:
+  //
+  // constructor
+  //
+  // If fragment is true, the data to be fed is a run of top-level
+  // elements cut from the inside of the <osm> element (e.g. one 
+  // chunk of the node section) rather than a whole document.
+  //
+  OsmReader(function<void(const OsmElement&)> visit, bool fragment = false);
+
+  //
+  // feed
+  //
+  // Parses as much of [data, data+len) as possible, returning the
+  // # of bytes consumed. Anything not consumed is an incomplete
+  // piece of markup, which must be passed again at the front of
+  // the next chunk.
+  //
+  size_t feed(const char* data, size_t len);
+
+  //
+  // accessors / getters
+  //
+  bool sawOsm();
+  bool failed();
+};
+
+
 //
 // Helper functions:
 //
 bool osmLoadMapFile(string filename, XMLDocument& xmldoc);
-bool osmContainsKeyValue(XMLElement* e, string key, string value);
-string osmGetKeyValue(XMLElement* e, string key);
+bool osmStreamMapFile(string filename, function<void(const OsmElement&)> visit);
+bool osmStreamMappedFile(string filename, function<void(const OsmElement&)> visit);
+bool osmParallelStreamMappedFile(string filename, int numThreads,
+  function<void(int chunk, const OsmElement&)> visitNode,
+  function<void(const OsmElement&)> visit);
+void osmReadElement(XMLElement* e, OsmElement& elem);
+bool osmContainsKeyValue(XMLElement* e, string_view key, string_view value);
+string_view osmGetKeyValue(XMLElement* e, string_view key);
+bool osmContainsKeyValue(const OsmElement& e, string_view key, string_view value);
+string_view osmGetKeyValue(const OsmElement& e, string_view key);
+int osmGetKeyValues(const OsmElement& e, span<const string_view> keys, span<string_view> values);
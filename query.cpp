@@ -0,0 +1,317 @@
+/*query.cpp*/
+
+//
+// Runs the b, a, f, w and i commands given as lines of text, for
+// batch mode, one at a time or on a pool of worker threads.
+//
+// Jay Rao
+// Northwestern University
+// CS 211
+//
+
+#include <cctype>
+#include <sstream>
+#include <algorithm>
+
+#include "query.h"
+
+using namespace std;
+
+
+//
+// splits a query into the command and the rest of the line, the
+// same as "cin >> cmd" followed by getline( ) at the prompt; the
+// command is "" if the line is blank:
+//
+static void splitQuery(const string& line, string& cmd, string& rest)
+{
+  size_t start = 0;
+
+  while (start < line.size() && isspace((unsigned char) line[start])) {
+    start++;
+  }
+
+  size_t end = start;
+
+  while (end < line.size() && !isspace((unsigned char) line[end])) {
+    end++;
+  }
+
+  cmd = line.substr(start, end - start);
+  rest = line.substr(end);
+}
+
+//
+// reads the next line, without a DOS line ending:
+//
+static bool readQuery(istream& in, string& line)
+{
+  if (!getline(in, line)) {
+    return false;
+  }
+
+  if (!line.empty() && line.back() == '\r') {
+    line.pop_back();
+  }
+
+  return true;
+}
+
+
+//
+// runQuery
+//
+bool runQuery(const string& line, const Nodes& nodes, const Buildings& buildings, const Amenities& amenities, ostream& out)
+{
+  string cmd, rest;
+
+  splitQuery(line, cmd, rest);
+
+  if (cmd == "") {  // blank:
+    return true;
+  }
+
+  if (cmd == "$") {
+    return false;
+  }
+
+  out << "> " << cmd << rest << '\n';
+
+  if (cmd == "b") {
+    buildings.findAndPrint(rest, nodes, out);
+  }
+
+  else if (cmd == "a") {
+    amenities.findAndPrint(rest, nodes, out);
+  }
+
+  else if (cmd == "f") {
+    vector< pair < int, pair <double, double> > > coordinates_list = buildings.fast_food_search(rest);
+    amenities.findNearestFastFood(amenities, buildings, nodes, (int) amenities.osmAmenities.size(), coordinates_list, out);
+  }
+
+  else if (cmd == "w") {
+    vector< pair < int, pair <double, double> > > coordinates_list = buildings.fast_food_search(rest);
+    amenities.findNearestFastFoodWalking(buildings, nodes, coordinates_list, out);
+  }
+
+  else if (cmd == "i") {
+    vector< pair < int, pair <double, double> > > coordinates_list = buildings.fast_food_search(rest);
+    amenities.findWithinWalking(buildings, nodes, coordinates_list, out);
+  }
+
+  else {
+    out << "Unknown command, please try again" << '\n';
+  }
+
+  return true;
+}
+
+
+//
+// runQueries
+//
+int runQueries(istream& in, const Nodes& nodes, const Buildings& buildings, const Amenities& amenities, ostream& out)
+{
+  int numQueries = 0;
+  string line, cmd, rest;
+
+  while (readQuery(in, line))
+  {
+    if (!runQuery(line, nodes, buildings, amenities, out)) {
+      break;
+    }
+
+    splitQuery(line, cmd, rest);
+
+    if (cmd != "") {
+      numQueries++;
+    }
+  }
+
+  return numQueries;
+}
+
+
+//
+// QueryPool:
+//
+
+//
+// constructor
+//
+QueryPool::QueryPool(const Nodes& nodes, const Buildings& buildings, const Amenities& amenities, int numThreads)
+  : MapNodes(nodes), MapBuildings(buildings), MapAmenities(amenities),
+    Queries(nullptr), Results(nullptr), NextQuery(0), NumBusy(0),
+    Generation(0), Stopping(false)
+{
+  for (int i = 0; i < max(1, numThreads); i++) {
+    this->Workers.push_back(thread(&QueryPool::work, this));
+  }
+}
+
+
+//
+// destructor
+//
+QueryPool::~QueryPool()
+{
+  {
+    lock_guard<mutex> guard(this->Lock);
+    this->Stopping = true;
+  }
+
+  this->Ready.notify_all();
+
+  for (thread& worker : this->Workers) {
+    worker.join();
+  }
+}
+
+
+//
+// getNumThreads
+//
+int QueryPool::getNumThreads() const
+{
+  return (int) this->Workers.size();
+}
+
+
+//
+// each worker waits for a call to run( ), then claims queries a
+// few at a time until there are none left:
+//
+void QueryPool::work()
+{
+  const size_t BLOCK = 16;  // queries claimed at a time
+
+  ostringstream buffer;  // this worker's output
+  unsigned long long seen = 0;
+
+  while (true)
+  {
+    const vector<string>* queries;
+    vector<string>* results;
+
+    {
+      unique_lock<mutex> guard(this->Lock);
+
+      this->Ready.wait(guard, [&]() { return this->Stopping || this->Generation != seen; });
+
+      if (this->Stopping) {
+        return;
+      }
+
+      seen = this->Generation;
+      queries = this->Queries;
+      results = this->Results;
+    }
+
+    while (true)
+    {
+      size_t first = this->NextQuery.fetch_add(BLOCK);
+
+      if (first >= queries->size()) {
+        break;
+      }
+
+      size_t last = min(first + BLOCK, queries->size());
+
+      for (size_t i = first; i < last; i++)
+      {
+        buffer.str("");
+
+        runQuery((*queries)[i], this->MapNodes, this->MapBuildings, this->MapAmenities, buffer);
+
+        (*results)[i] = buffer.str();
+      }
+    }
+
+    {
+      lock_guard<mutex> guard(this->Lock);
+
+      this->NumBusy--;
+
+      if (this->NumBusy == 0) {
+        this->Done.notify_one();
+      }
+    }
+  }
+}
+
+
+//
+// run
+//
+vector<string> QueryPool::run(const vector<string>& queries)
+{
+  vector<string> results(queries.size());
+
+  unique_lock<mutex> guard(this->Lock);
+
+  this->Queries = &queries;
+  this->Results = &results;
+  this->NextQuery = 0;
+  this->NumBusy = (int) this->Workers.size();
+  this->Generation++;
+
+  this->Ready.notify_all();
+
+  this->Done.wait(guard, [&]() { return this->NumBusy == 0; });
+
+  this->Queries = nullptr;
+  this->Results = nullptr;
+
+  return results;
+}
+
+
+//
+// runQueries
+//
+int QueryPool::runQueries(istream& in, ostream& out)
+{
+  //
+  // lines are read and run a block at a time, so the memory used
+  // doesn't grow with the # of queries, and output starts early:
+  //
+  const size_t BLOCK = 4096;
+
+  int numQueries = 0;
+  bool more = true;
+  string line, cmd, rest;
+  vector<string> queries;
+
+  while (more)
+  {
+    queries.clear();
+
+    while (queries.size() < BLOCK)
+    {
+      if (!readQuery(in, line)) {
+        more = false;
+        break;
+      }
+
+      splitQuery(line, cmd, rest);
+
+      if (cmd == "$") {
+        more = false;
+        break;
+      }
+
+      if (cmd != "") {
+        queries.push_back(line);
+      }
+    }
+
+    for (const string& result : this->run(queries)) {
+      out << result;
+    }
+
+    numQueries += (int) queries.size();
+  }
+
+  return numQueries;
+}
@@ -0,0 +1,143 @@
+/*query.h*/
+
+/**
+  * @brief runs the b, a, f, w and i commands without the interactive prompt.
+  *
+  * A query is one line of text, the same as typed at the prompt,
+  * e.g. "b mudd", "a cafe", "f tech", "w tech" or "i tech". Used by batch mode, which
+  * reads the queries from a file (or standard input) and writes
+  * all the results to one buffered stream.
+  *
+  * Queries only read the map, so any number of them can run at
+  * once against the same Nodes, Buildings and Amenities; QueryPool
+  * runs them on a set of worker threads.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+
+using namespace std;
+
+
+/**
+  * @brief runs one query against the map.
+  *
+  * Blank lines are ignored; "$" ends the queries. Anything else is
+  * echoed to the output as "> query", followed by its results.
+  *
+  * @param line The query.
+  * @param nodes The nodes of the map.
+  * @param buildings The buildings of the map.
+  * @param amenities The amenities of the map.
+  * @param out Where to write the results.
+  * @return false if the line is "$", true otherwise
+  */
+bool runQuery(const string& line, const Nodes& nodes, const Buildings& buildings, const Amenities& amenities, ostream& out);
+
+/**
+  * @brief runs every query in the stream, one per line, up to the
+  * end of the stream or a line containing "$".
+  *
+  * The output is not flushed after each query.
+  *
+  * @param in The queries.
+  * @param nodes The nodes of the map.
+  * @param buildings The buildings of the map.
+  * @param amenities The amenities of the map.
+  * @param out Where to write the results.
+  * @return the # of queries run
+  */
+int runQueries(istream& in, const Nodes& nodes, const Buildings& buildings, const Amenities& amenities, ostream& out);
+
+
+/**
+  * @brief a set of worker threads that run queries in parallel
+  * against one (read-only) map.
+  *
+  * Each worker writes the results of its queries to its own
+  * buffer; run( ) returns the results in the order the queries
+  * were given, so the output is the same as running them one at a
+  * time.
+  */
+class QueryPool
+{
+public:
+/**
+  * @brief starts the worker threads.
+  *
+  * The map must not change while the pool exists.
+  *
+  * @param nodes The nodes of the map.
+  * @param buildings The buildings of the map.
+  * @param amenities The amenities of the map.
+  * @param numThreads The # of worker threads, at least 1.
+  */
+  QueryPool(const Nodes& nodes, const Buildings& buildings, const Amenities& amenities, int numThreads);
+
+  // stops the worker threads:
+  ~QueryPool();
+
+  QueryPool(const QueryPool& other) = delete;
+  QueryPool& operator=(const QueryPool& other) = delete;
+
+/**
+  * @brief runs the queries, in parallel, waiting for all of them.
+  *
+  * Only one thread at a time may call run( ).
+  *
+  * @param queries The queries, see runQuery( ); "$" is ignored.
+  * @return the output of each query, in the same order
+  */
+  vector<string> run(const vector<string>& queries);
+
+/**
+  * @brief reads the queries in the stream, one per line, up to the
+  * end of the stream or a line containing "$", and runs them in
+  * parallel, a block of lines at a time.
+  *
+  * @param in The queries.
+  * @param out Where to write the results, in order.
+  * @return the # of queries run
+  */
+  int runQueries(istream& in, ostream& out);
+
+  // the # of worker threads:
+  int getNumThreads() const;
+
+private:
+  const Nodes&     MapNodes;
+  const Buildings& MapBuildings;
+  const Amenities& MapAmenities;
+
+  vector<thread> Workers;
+
+  //
+  // the queries being run; workers claim them a few at a time
+  // via NextQuery, and the last worker to finish signals Done:
+  //
+  mutex                   Lock;
+  condition_variable      Ready;
+  condition_variable      Done;
+  const vector<string>*   Queries;
+  vector<string>*         Results;
+  atomic<size_t>          NextQuery;
+  int                     NumBusy;
+  unsigned long long      Generation;  // counts calls to run( )
+  bool                    Stopping;
+
+  void work();
+};
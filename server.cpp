@@ -0,0 +1,926 @@
+/*server.cpp*/
+
+//
+// HTTP server answering map queries in JSON, one thread running
+// an epoll event loop over non-blocking sockets.
+//
+// Jay Rao
+// Northwestern University
+// CS 211
+//
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "server.h"
+
+using namespace std;
+
+
+//
+// limits on what a client may send, and on what the server holds
+// for it: a connection's input is read no further than one whole
+// request, and no more requests are answered while its responses
+// not yet sent pass the high-water mark (e.g. a client that sends
+// requests but never reads the responses):
+//
+static const size_t MAX_HEADER_SIZE = 64 * 1024;
+static const size_t MAX_BODY_SIZE = 1024 * 1024;
+static const size_t MAX_REQUEST_SIZE = MAX_HEADER_SIZE + 4 + MAX_BODY_SIZE;
+static const size_t MAX_PENDING_OUTPUT = 1024 * 1024;
+static const size_t MAX_CONNECTIONS = 1024;
+
+//
+// the stop eventfd of the running server, written to by the
+// signal handler:
+//
+static volatile int SignalStopFd = -1;
+
+static void onStopSignal(int)
+{
+  uint64_t one = 1;
+
+  if (SignalStopFd >= 0) {
+    ssize_t ignored = write(SignalStopFd, &one, sizeof(one));
+    (void) ignored;
+  }
+}
+
+
+//
+// JSON output helpers:
+//
+static void writeJsonString(ostream& out, string_view s)
+{
+  out << '"';
+
+  for (char c : s)
+  {
+    switch (c)
+    {
+      case '"':  out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      case '\r': out << "\\r"; break;
+      case '\t': out << "\\t"; break;
+      default:
+        if ((unsigned char) c < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) c);
+          out << escaped;
+        }
+        else {
+          out << c;
+        }
+    }
+  }
+
+  out << '"';
+}
+
+// JSON has no NaN or infinity, e.g. the location of a building
+// with no nodes in the map:
+static void writeJsonNumber(ostream& out, double x)
+{
+  if (std::isfinite(x)) {
+    out << x;
+  }
+  else {
+    out << "null";
+  }
+}
+
+static void writeJsonLocation(ostream& out, pair<double, double> location)
+{
+  out << "{\"lat\":";
+  writeJsonNumber(out, location.first);
+  out << ",\"lon\":";
+  writeJsonNumber(out, location.second);
+  out << "}";
+}
+
+// the nodes in order of id, like the detailed print( ):
+static void writeJsonNodes(ostream& out, span<const uint32_t> indices, const Nodes& nodes)
+{
+  NodeTable table = nodes.getTable();
+
+  vector<uint32_t> sorted(indices.begin(), indices.end());
+
+  sort(sorted.begin(), sorted.end());
+
+  out << "[";
+
+  for (size_t i = 0; i < sorted.size(); i++)
+  {
+    uint32_t n = sorted[i];
+
+    out << (i > 0 ? "," : "") << "{\"id\":" << table.IDs[n] << ",\"lat\":";
+    writeJsonNumber(out, table.getLat(n));
+    out << ",\"lon\":";
+    writeJsonNumber(out, table.getLon(n));
+    out << ",\"entrance\":" << (table.getIsEntrance(n) ? "true" : "false") << "}";
+  }
+
+  out << "]";
+}
+
+static void writeJsonBuilding(ostream& out, const Building& B, const Nodes& nodes, bool detailed)
+{
+  out << "{\"id\":" << B.getID() << ",\"name\":";
+  writeJsonString(out, B.getName());
+  out << ",\"address\":";
+  writeJsonString(out, B.getStreetAddress());
+
+  if (detailed) {
+    out << ",\"location\":";
+    writeJsonLocation(out, B.getLocation());
+    out << ",\"nodes\":";
+    writeJsonNodes(out, B.getNodeIndices(), nodes);
+  }
+
+  out << "}";
+}
+
+static void writeJsonAmenity(ostream& out, const Amenity& A, const Nodes& nodes, bool detailed)
+{
+  out << "{\"id\":" << A.getID() << ",\"name\":";
+  writeJsonString(out, A.getName());
+  out << ",\"type\":";
+  writeJsonString(out, A.getAmenityType());
+  out << ",\"address\":";
+  writeJsonString(out, A.getStreetAddress());
+  out << ",\"location\":";
+  writeJsonLocation(out, A.getLocation());
+
+  if (detailed) {
+    out << ",\"nodes\":";
+    writeJsonNodes(out, A.getNodeIndices(), nodes);
+  }
+
+  out << "}";
+}
+
+
+//
+// URL helpers:
+//
+static int hexValue(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// decodes %XX escapes, and + as a space:
+static string urlDecode(string_view s)
+{
+  string result;
+
+  for (size_t i = 0; i < s.size(); i++)
+  {
+    if (s[i] == '+') {
+      result += ' ';
+    }
+    else if (s[i] == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0) {
+      result += (char) (hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+      i += 2;
+    }
+    else {
+      result += s[i];
+    }
+  }
+
+  return result;
+}
+
+// the value of the given parameter in a query string, "" if absent:
+static string queryParameter(string_view query, string_view name)
+{
+  while (!query.empty())
+  {
+    size_t amp = query.find('&');
+    string_view param = query.substr(0, amp);
+    size_t eq = param.find('=');
+
+    if (urlDecode(param.substr(0, eq)) == name) {
+      return (eq == string_view::npos) ? "" : urlDecode(param.substr(eq + 1));
+    }
+
+    if (amp == string_view::npos) {
+      break;
+    }
+
+    query.remove_prefix(amp + 1);
+  }
+
+  return "";
+}
+
+static bool equalsIgnoreCase(string_view a, string_view b)
+{
+  if (a.size() != b.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < a.size(); i++) {
+    if (tolower((unsigned char) a[i]) != tolower((unsigned char) b[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static string_view trim(string_view s)
+{
+  while (!s.empty() && isspace((unsigned char) s.front())) s.remove_prefix(1);
+  while (!s.empty() && isspace((unsigned char) s.back())) s.remove_suffix(1);
+
+  return s;
+}
+
+static const char* statusText(int status)
+{
+  switch (status)
+  {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    default:  return "Error";
+  }
+}
+
+static void appendResponse(string& out, int status, const string& body, bool keepAlive)
+{
+  out += "HTTP/1.1 " + to_string(status) + " " + statusText(status) + "\r\n";
+  out += "Content-Type: application/json\r\n";
+  out += "Content-Length: " + to_string(body.size()) + "\r\n";
+
+  if (status == 405) {
+    out += "Allow: GET\r\n";
+  }
+  if (!keepAlive) {
+    out += "Connection: close\r\n";
+  }
+
+  out += "\r\n";
+  out += body;
+}
+
+
+//
+// constructor
+//
+QueryServer::QueryServer(const Nodes& nodes, const Buildings& buildings, const Amenities& amenities)
+  : MapNodes(nodes), MapBuildings(buildings), MapAmenities(amenities),
+    ListenFd(-1), EpollFd(-1), StopFd(-1), Accepting(true)
+{
+}
+
+
+//
+// destructor
+//
+QueryServer::~QueryServer()
+{
+  for (auto& [fd, conn] : this->Connections) {
+    ::close(fd);
+  }
+
+  if (this->ListenFd >= 0) ::close(this->ListenFd);
+  if (this->EpollFd >= 0) ::close(this->EpollFd);
+  if (this->StopFd >= 0) ::close(this->StopFd);
+
+  if (!this->UnixPath.empty()) {
+    unlink(this->UnixPath.c_str());
+  }
+}
+
+
+//
+// listen
+//
+bool QueryServer::listen(const string& address)
+{
+  int fd = -1;
+
+  if (address.rfind("unix:", 0) == 0)
+  {
+    string path = address.substr(5);
+    sockaddr_un addr = {};
+
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+      cout << "**ERROR: invalid socket path '" << path << "'" << endl;
+      return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    unlink(path.c_str());  // left over from a previous run
+
+    if (fd < 0 || bind(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+      cout << "**ERROR: unable to listen on '" << address << "': " << strerror(errno) << endl;
+      if (fd >= 0) ::close(fd);
+      return false;
+    }
+
+    this->UnixPath = path;
+  }
+  else
+  {
+    //
+    // [host:]port, loopback by default:
+    //
+    string host = "127.0.0.1";
+    string port = address;
+    size_t colon = address.rfind(':');
+
+    if (colon != string::npos) {
+      host = address.substr(0, colon);
+      port = address.substr(colon + 1);
+    }
+
+    sockaddr_in addr = {};
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t) atoi(port.c_str()));
+
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 || atoi(port.c_str()) <= 0) {
+      cout << "**ERROR: invalid address '" << address << "'" << endl;
+      return false;
+    }
+
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    int on = 1;
+
+    if (fd >= 0) {
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+
+    if (fd < 0 || bind(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+      cout << "**ERROR: unable to listen on '" << address << "': " << strerror(errno) << endl;
+      if (fd >= 0) ::close(fd);
+      return false;
+    }
+  }
+
+  if (::listen(fd, SOMAXCONN) < 0) {
+    cout << "**ERROR: unable to listen on '" << address << "': " << strerror(errno) << endl;
+    ::close(fd);
+    return false;
+  }
+
+  this->ListenFd = fd;
+  this->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+  this->StopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  epoll_event ev = {};
+
+  ev.events = EPOLLIN;
+  ev.data.fd = this->ListenFd;
+  epoll_ctl(this->EpollFd, EPOLL_CTL_ADD, this->ListenFd, &ev);
+
+  ev.data.fd = this->StopFd;
+  epoll_ctl(this->EpollFd, EPOLL_CTL_ADD, this->StopFd, &ev);
+
+  return true;
+}
+
+
+//
+// stop
+//
+void QueryServer::stop()
+{
+  uint64_t one = 1;
+
+  ssize_t ignored = write(this->StopFd, &one, sizeof(one));
+  (void) ignored;
+}
+
+
+//
+// run
+//
+void QueryServer::run()
+{
+  //
+  // SIGINT / SIGTERM stop the loop; a client that disconnects
+  // early must not kill the server with SIGPIPE:
+  //
+  SignalStopFd = this->StopFd;
+
+  struct sigaction action = {};
+
+  action.sa_handler = onStopSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  const int MAX_EVENTS = 64;
+  epoll_event events[MAX_EVENTS];
+  bool stopping = false;
+
+  while (!stopping)
+  {
+    //
+    // while not accepting (see acceptConnections), wake up now and
+    // then to try again, in case no connection closes to free up a
+    // descriptor:
+    //
+    int n = epoll_wait(this->EpollFd, events, MAX_EVENTS, this->Accepting ? -1 : 100);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      cout << "**ERROR: epoll_wait: " << strerror(errno) << endl;
+      break;
+    }
+
+    if (n == 0) {
+      this->resumeAccepting();
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+      int fd = events[i].data.fd;
+
+      if (fd == this->StopFd) {
+        stopping = true;
+        continue;
+      }
+
+      if (fd == this->ListenFd) {
+        this->acceptConnections();
+        continue;
+      }
+
+      unordered_map<int, Connection>::iterator it = this->Connections.find(fd);
+
+      if (it == this->Connections.end()) {
+        continue;
+      }
+
+      Connection& conn = it->second;
+
+      if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        this->readRequests(fd, conn);
+      }
+
+      this->answerRequests(conn);
+
+      bool ok = this->sendResponses(fd, conn);
+
+      //
+      // answering stops at the high-water mark; once the responses
+      // have all gone out, answer the requests left over, as there
+      // may be no further events for them:
+      //
+      while (ok && conn.Out.empty() && !conn.In.empty())
+      {
+        size_t unanswered = conn.In.size();
+
+        this->answerRequests(conn);
+
+        if (conn.In.size() == unanswered && conn.Out.empty()) {
+          break;  // only part of a request
+        }
+
+        ok = this->sendResponses(fd, conn);
+      }
+
+      if (!ok || (conn.Closing && conn.Out.empty())) {
+        this->closeConnection(fd);
+      }
+    }
+  }
+
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+  SignalStopFd = -1;
+}
+
+
+//
+// accepts all the pending connections. At the connection limit, or
+// out of descriptors, the listening socket stays readable, so it's
+// taken out of the event loop until a connection closes (or for a
+// moment, see run) rather than waking the loop over and over:
+//
+void QueryServer::acceptConnections()
+{
+  while (true)
+  {
+    if (this->Connections.size() >= MAX_CONNECTIONS) {
+      this->pauseAccepting();
+      return;
+    }
+
+    int fd = accept4(this->ListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (fd < 0)
+    {
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+        this->pauseAccepting();
+      }
+      return;  // none left
+    }
+
+    //
+    // responses are small and written whole, so don't let Nagle's
+    // algorithm hold them back (fails harmlessly on Unix sockets):
+    //
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    epoll_event ev = {};
+
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(this->EpollFd, EPOLL_CTL_ADD, fd, &ev);
+
+    Connection& conn = this->Connections[fd];
+
+    conn.Sent = 0;
+    conn.Closing = false;
+    conn.Events = EPOLLIN;
+  }
+}
+
+
+void QueryServer::pauseAccepting()
+{
+  if (!this->Accepting) {
+    return;
+  }
+
+  epoll_event ev = {};
+
+  ev.events = 0;
+  ev.data.fd = this->ListenFd;
+  epoll_ctl(this->EpollFd, EPOLL_CTL_MOD, this->ListenFd, &ev);
+
+  this->Accepting = false;
+}
+
+void QueryServer::resumeAccepting()
+{
+  if (this->Accepting) {
+    return;
+  }
+
+  epoll_event ev = {};
+
+  ev.events = EPOLLIN;
+  ev.data.fd = this->ListenFd;
+  epoll_ctl(this->EpollFd, EPOLL_CTL_MOD, this->ListenFd, &ev);
+
+  this->Accepting = true;
+}
+
+
+//
+// reads whatever has arrived, up to one whole request beyond what's
+// already held; at end of input (or on an error) the connection is
+// closed once the complete requests are answered:
+//
+void QueryServer::readRequests(int fd, Connection& conn)
+{
+  char buffer[16 * 1024];
+
+  while (!conn.Closing && conn.In.size() < MAX_REQUEST_SIZE)
+  {
+    size_t room = min(sizeof(buffer), MAX_REQUEST_SIZE - conn.In.size());
+    ssize_t n = recv(fd, buffer, room, 0);
+
+    if (n > 0) {
+      conn.In.append(buffer, n);
+    }
+    else if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    }
+    else {
+      conn.Closing = true;
+    }
+  }
+}
+
+
+//
+// answers every complete request received so far, in order:
+//
+void QueryServer::answerRequests(Connection& conn)
+{
+  while (conn.Out.size() < MAX_PENDING_OUTPUT)
+  {
+    size_t headerEnd = conn.In.find("\r\n\r\n");
+
+    if (headerEnd == string::npos || headerEnd > MAX_HEADER_SIZE) {
+      if (conn.In.size() > MAX_HEADER_SIZE) {
+        appendResponse(conn.Out, 431, "{\"error\":\"request header too large\"}", false);
+        conn.Closing = true;
+        conn.In.clear();
+      }
+      return;
+    }
+
+    //
+    // request line: METHOD target HTTP/1.x
+    //
+    string_view header(conn.In.data(), headerEnd);
+    size_t lineEnd = header.find("\r\n");
+    string_view requestLine = header.substr(0, lineEnd);
+
+    size_t sp1 = requestLine.find(' ');
+    size_t sp2 = requestLine.rfind(' ');
+
+    if (sp1 == string_view::npos || sp2 == sp1) {
+      appendResponse(conn.Out, 400, "{\"error\":\"bad request\"}", false);
+      conn.Closing = true;
+      conn.In.clear();
+      return;
+    }
+
+    string method(requestLine.substr(0, sp1));
+    string target(requestLine.substr(sp1 + 1, sp2 - sp1 - 1));
+    string_view version = requestLine.substr(sp2 + 1);
+
+    //
+    // headers; only Connection and Content-Length matter:
+    //
+    bool keepAlive = (version == "HTTP/1.1");
+    size_t contentLength = 0;
+
+    while (lineEnd != string_view::npos)
+    {
+      size_t next = header.find("\r\n", lineEnd + 2);
+      string_view line = header.substr(lineEnd + 2, (next == string_view::npos) ? string_view::npos : next - lineEnd - 2);
+      size_t colon = line.find(':');
+
+      if (colon != string_view::npos)
+      {
+        string_view name = trim(line.substr(0, colon));
+        string_view value = trim(line.substr(colon + 1));
+
+        if (equalsIgnoreCase(name, "Connection")) {
+          if (equalsIgnoreCase(value, "close")) keepAlive = false;
+          if (equalsIgnoreCase(value, "keep-alive")) keepAlive = true;
+        }
+        else if (equalsIgnoreCase(name, "Content-Length")) {
+          contentLength = strtoull(string(value).c_str(), nullptr, 10);
+        }
+      }
+
+      lineEnd = next;
+    }
+
+    if (contentLength > MAX_BODY_SIZE) {
+      appendResponse(conn.Out, 413, "{\"error\":\"request body too large\"}", false);
+      conn.Closing = true;
+      conn.In.clear();
+      return;
+    }
+
+    size_t requestSize = headerEnd + 4 + contentLength;
+
+    if (conn.In.size() < requestSize) {
+      return;  // the body hasn't all arrived
+    }
+
+    string body;
+    int status = this->handle(method, target, body);
+
+    appendResponse(conn.Out, status, body, keepAlive);
+
+    conn.In.erase(0, requestSize);
+
+    if (!keepAlive) {
+      conn.Closing = true;
+      conn.In.clear();
+      return;
+    }
+  }
+}
+
+
+//
+// sends as much of the responses as the socket takes; returns
+// false if the connection failed:
+//
+bool QueryServer::sendResponses(int fd, Connection& conn)
+{
+  while (conn.Sent < conn.Out.size())
+  {
+    ssize_t n = send(fd, conn.Out.data() + conn.Sent, conn.Out.size() - conn.Sent, MSG_NOSIGNAL);
+
+    if (n >= 0) {
+      conn.Sent += n;
+    }
+    else if (errno == EINTR) {
+      continue;
+    }
+    else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    }
+    else {
+      return false;
+    }
+  }
+
+  if (conn.Sent == conn.Out.size()) {
+    conn.Out.clear();
+    conn.Sent = 0;
+  }
+
+  //
+  // wait for room to send the rest, and for more requests unless
+  // closing or holding as much as allowed:
+  //
+  uint32_t events = 0;
+
+  if (!conn.Closing && conn.In.size() < MAX_REQUEST_SIZE && conn.Out.size() < MAX_PENDING_OUTPUT) {
+    events |= EPOLLIN;
+  }
+
+  if (!conn.Out.empty()) {
+    events |= EPOLLOUT;
+  }
+
+  this->waitFor(fd, conn, events);
+
+  return true;
+}
+
+void QueryServer::waitFor(int fd, Connection& conn, uint32_t events)
+{
+  if (conn.Events == events) {
+    return;
+  }
+
+  epoll_event ev = {};
+
+  ev.events = events;
+  ev.data.fd = fd;
+  epoll_ctl(this->EpollFd, EPOLL_CTL_MOD, fd, &ev);
+
+  conn.Events = events;
+}
+
+
+//
+// closeConnection
+//
+void QueryServer::closeConnection(int fd)
+{
+  epoll_ctl(this->EpollFd, EPOLL_CTL_DEL, fd, nullptr);
+  ::close(fd);
+
+  this->Connections.erase(fd);
+
+  this->resumeAccepting();
+}
+
+
+//
+// handle
+//
+int QueryServer::handle(const string& method, const string& target, string& body) const
+{
+  size_t question = target.find('?');
+  string path = target.substr(0, question);
+  string_view query = (question == string::npos) ? string_view() : string_view(target).substr(question + 1);
+
+  ostringstream out;
+
+  out.precision(10);
+
+  if (path != "/buildings" && path != "/amenities" && path != "/fast-food/nearest") {
+    body = "{\"error\":\"not found\"}";
+    return 404;
+  }
+
+  if (method != "GET") {
+    body = "{\"error\":\"method not allowed\"}";
+    return 405;
+  }
+
+  if (path == "/buildings")
+  {
+    //
+    // all the buildings in summary form, or the matches in detail:
+    //
+    string name = queryParameter(query, "name");
+    bool all = (trim(name).empty());
+    vector<int> matches = this->MapBuildings.findByName(name);
+
+    out << "{\"buildings\":[";
+
+    for (size_t i = 0; i < matches.size(); i++) {
+      out << (i > 0 ? "," : "");
+      writeJsonBuilding(out, this->MapBuildings.osmBuildings[matches[i]], this->MapNodes, !all);
+    }
+
+    out << "]}";
+  }
+
+  else if (path == "/amenities")
+  {
+    //
+    // all the amenity types, or the matching amenities in detail:
+    //
+    string type = queryParameter(query, "type");
+
+    if (trim(type).empty())
+    {
+      out << "{\"types\":[";
+
+      for (size_t i = 0; i < this->MapAmenities.amenityTypes.size(); i++) {
+        out << (i > 0 ? "," : "");
+        writeJsonString(out, this->MapAmenities.amenityTypes[i]);
+      }
+
+      out << "]}";
+    }
+    else
+    {
+      vector<int> matches = this->MapAmenities.findByType(type);
+
+      out << "{\"amenities\":[";
+
+      for (size_t i = 0; i < matches.size(); i++) {
+        out << (i > 0 ? "," : "");
+        writeJsonAmenity(out, this->MapAmenities.osmAmenities[matches[i]], this->MapNodes, true);
+      }
+
+      out << "]}";
+    }
+  }
+
+  else  // "/fast-food/nearest"
+  {
+    string name = queryParameter(query, "building");
+    bool walk = (queryParameter(query, "mode") == "walk");
+    vector<int> matches = this->MapBuildings.findByName(name);
+
+    out << "{\"results\":[";
+
+    for (size_t i = 0; i < matches.size(); i++)
+    {
+      const Building& B = this->MapBuildings.osmBuildings[matches[i]];
+      pair<double, double> location = B.getLocation();
+
+      float distance;
+      int nearest = walk ?
+        this->MapAmenities.findNearestFastFoodWalking(this->MapBuildings, this->MapNodes, matches[i], distance) :
+        this->MapAmenities.findNearestFastFood(location.first, location.second, distance);
+
+      out << (i > 0 ? "," : "") << "{\"building\":";
+      writeJsonBuilding(out, B, this->MapNodes, false);
+      out << ",\"fast_food\":";
+
+      if (nearest < 0) {
+        out << "null";
+      }
+      else {
+        writeJsonAmenity(out, this->MapAmenities.osmAmenities[nearest], this->MapNodes, false);
+        out << ",\"distance_miles\":";
+        writeJsonNumber(out, distance);
+      }
+
+      out << "}";
+    }
+
+    out << "]}";
+  }
+
+  body = out.str();
+
+  return 200;
+}
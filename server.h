@@ -0,0 +1,131 @@
+/*server.h*/
+
+/**
+  * @brief HTTP server answering map queries in JSON.
+  *
+  * Serves the b, a, f and w queries over HTTP/1.1, on a loopback TCP
+  * port or a Unix domain socket, from one loaded map:
+  *
+  *   GET /buildings?name=mudd           buildings whose name contains
+  *                                      the text (all if empty)
+  *   GET /amenities?type=cafe           amenities whose type contains
+  *                                      the text (all types if empty)
+  *   GET /fast-food/nearest?building=x  nearest fast food to each
+  *                                      building matching the text;
+  *                                      add &mode=walk for walking
+  *                                      distance from its entrances
+  *
+  * One thread runs an epoll event loop over non-blocking sockets.
+  * Connections are kept alive (HTTP/1.1 default), and pipelined
+  * requests are answered in order. At most 1024 connections are
+  * open at once, and a client that doesn't read its responses is
+  * not read from until it catches up.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+
+using namespace std;
+
+
+/**
+  * @brief HTTP server answering map queries in JSON.
+  */
+class QueryServer
+{
+public:
+/**
+  * @brief constructor; the map must not change while the server
+  * exists.
+  *
+  * @param nodes The nodes of the map.
+  * @param buildings The buildings of the map.
+  * @param amenities The amenities of the map.
+  */
+  QueryServer(const Nodes& nodes, const Buildings& buildings, const Amenities& amenities);
+
+  // closes the listening socket and all connections:
+  ~QueryServer();
+
+  QueryServer(const QueryServer& other) = delete;
+  QueryServer& operator=(const QueryServer& other) = delete;
+
+/**
+  * @brief starts listening.
+  *
+  * The address is a port on the loopback interface ("8211" or
+  * "127.0.0.1:8211"), or "unix:" followed by the path of a Unix
+  * domain socket to create.
+  *
+  * @param address Where to listen.
+  * @return true if successful, false if not (an error message is
+  *   output)
+  */
+  bool listen(const string& address);
+
+/**
+  * @brief answers requests until interrupted (SIGINT or SIGTERM),
+  * or until stop( ) is called.
+  *
+  * @return nothing
+  */
+  void run();
+
+/**
+  * @brief makes run( ) return; may be called from any thread.
+  *
+  * @return nothing
+  */
+  void stop();
+
+/**
+  * @brief answers one request.
+  *
+  * @param method The HTTP method, e.g. "GET".
+  * @param target The path and query string, e.g. "/buildings?name=mudd".
+  * @param body Output: the JSON response.
+  * @return the HTTP status code
+  */
+  int handle(const string& method, const string& target, string& body) const;
+
+private:
+  const Nodes&     MapNodes;
+  const Buildings& MapBuildings;
+  const Amenities& MapAmenities;
+
+  int    ListenFd;
+  int    EpollFd;
+  int    StopFd;    // eventfd, written to stop the event loop
+  bool   Accepting; // whether the listening socket is being watched
+  string UnixPath;  // to remove when done, if listening on one
+
+  struct Connection
+  {
+    string In;        // received, not yet answered
+    string Out;       // responses not yet sent
+    size_t Sent;      // bytes of Out already sent
+    bool   Closing;   // close once Out is sent
+    uint32_t Events;  // the epoll events being waited for
+  };
+
+  unordered_map<int, Connection> Connections;
+
+  void acceptConnections();
+  void pauseAccepting();
+  void resumeAccepting();
+  void readRequests(int fd, Connection& conn);
+  void answerRequests(Connection& conn);
+  bool sendResponses(int fd, Connection& conn);
+  void waitFor(int fd, Connection& conn, uint32_t events);
+  void closeConnection(int fd);
+};
@@ -0,0 +1,575 @@
+/*snapshot.cpp*/
+
+/**
+  * @brief binary snapshot of the parsed map.
+  *
+  * Parsing the XML map file dominates startup, so once the nodes,
+  * buildings, amenities and walking graph have been parsed (and
+  * the graph's contraction hierarchy built) they are saved to a
+  * compact binary snapshot next to the map file. Later runs load 
+  * the snapshot instead, as long as the map file has not changed
+  * (same size, modification time and content hash). The snapshot
+  * is memory-mapped and its tables are used in place.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <sys/stat.h>
+
+#include "snapshot.h"
+#include "nodes.h"
+#include "buildings.h"
+#include "amenities.h"
+#include "graph.h"
+#include "hierarchy.h"
+
+using namespace std;
+
+
+static const char     SNAPSHOT_MAGIC[8] = { 'N', 'U', 'O', 'S', 'M', 'S', 'N', 'P' };
+static const uint32_t SNAPSHOT_VERSION = 6;
+
+//
+// where a section is in the file, and its # of records:
+//
+struct SnapshotSection
+{
+  uint64_t Offset;
+  uint64_t Count;
+};
+
+//
+// fixed-size header at the start of every snapshot:
+//
+struct SnapshotHeader
+{
+  char     Magic[8];
+  uint32_t Version;
+  uint32_t CoordSize;    // sizeof(NodeCoord) of the program that wrote it
+  uint64_t SourceSize;
+  int64_t  SourceMtime;  // nanoseconds
+  uint64_t SourceHash;
+
+  SnapshotSection NodeIDs;
+  SnapshotSection NodeLats;
+  SnapshotSection NodeLons;
+  SnapshotSection NodeEntrances;
+  SnapshotSection NodeIndices;
+  SnapshotSection Buildings;
+  SnapshotSection Amenities;
+  SnapshotSection Types;
+  SnapshotSection GraphOffsets;
+  SnapshotSection GraphTargets;
+  SnapshotSection GraphWeights;
+  SnapshotSection HierarchyOffsets;
+  SnapshotSection HierarchyTargets;
+  SnapshotSection HierarchyWeights;
+  SnapshotSection Pool;   // count is in bytes
+};
+
+
+//
+// SnapshotWriter
+//
+SnapshotString SnapshotWriter::addString(string_view s)
+{
+  SnapshotString ref;
+
+  ref.Offset = (uint32_t) this->Pool.size();
+  ref.Length = (uint32_t) s.size();
+
+  this->Pool.append(s);
+
+  return ref;
+}
+
+uint64_t SnapshotWriter::addNodeIndices(span<const uint32_t> indices)
+{
+  uint64_t offset = this->NodeIndexTable.size();
+
+  this->NodeIndexTable.insert(this->NodeIndexTable.end(), indices.begin(), indices.end());
+
+  return offset;
+}
+
+
+//
+// sourceFingerprint
+//
+// Fills in the size, modification time and content hash of the
+// given map file, returning false if the file does not exist. So
+// that checking the fingerprint stays cheap for very large maps,
+// the hash (64-bit FNV-1a) covers the first and last 64 KB of the
+// file rather than all of it; together with size and mtime this
+// catches any realistic change to the file.
+//
+static bool sourceFingerprint(string osmFilename, SnapshotHeader& header)
+{
+  struct stat info;
+
+  if (stat(osmFilename.c_str(), &info) != 0) {
+    return false;
+  }
+
+  header.SourceSize = (uint64_t) info.st_size;
+  header.SourceMtime = (int64_t) info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+
+  ifstream file(osmFilename, ios::binary);
+
+  if (!file.good()) {
+    return false;
+  }
+
+  const size_t SAMPLE = 64 * 1024;
+  vector<char> sample(SAMPLE);
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (int i = 0; i < 2; i++)
+  {
+    if (i == 1) {  // last 64 KB:
+      if (header.SourceSize <= SAMPLE) break;
+      file.seekg((streamoff) (header.SourceSize - SAMPLE));
+    }
+
+    file.read(sample.data(), SAMPLE);
+    size_t n = (size_t) file.gcount();
+
+    for (size_t j = 0; j < n; j++) {
+      hash = (hash ^ (unsigned char) sample[j]) * 1099511628211ULL;
+    }
+
+    file.clear();
+  }
+
+  header.SourceHash = hash;
+
+  return true;
+}
+
+
+//
+// local helper to write one section of the snapshot, followed by
+// padding so the next section starts on an 8-byte boundary:
+//
+static void writeSection(ofstream& file, const void* data, size_t bytes)
+{
+  static const char zeros[8] = { 0 };
+
+  file.write((const char*) data, bytes);
+  file.write(zeros, (8 - bytes % 8) % 8);
+}
+
+static uint64_t paddedSize(size_t bytes)
+{
+  return (bytes + 7) / 8 * 8;
+}
+
+
+//
+// snapshotSave
+//
+// Saves the parsed map to the given snapshot file. The snapshot 
+// is first written to a temporary file and then renamed, so a
+// concurrent reader never sees a half-written snapshot.
+//
+bool snapshotSave(string snapFilename, string osmFilename, Nodes& nodes, Buildings& buildings, Amenities& amenities, Graph& graph,
+  ContractionHierarchy& hierarchy)
+{
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+
+  if (!sourceFingerprint(osmFilename, header)) {
+    return false;
+  }
+
+  SnapshotWriter writer;
+
+  nodes.writeSnapshot(writer);
+  buildings.writeSnapshot(writer);
+  amenities.writeSnapshot(writer);
+  graph.writeSnapshot(writer);
+  hierarchy.writeSnapshot(writer);
+
+  memcpy(header.Magic, SNAPSHOT_MAGIC, sizeof(header.Magic));
+  header.Version = SNAPSHOT_VERSION;
+  header.CoordSize = sizeof(NodeCoord);
+
+  //
+  // lay out the sections one after the other:
+  //
+  uint64_t offset = paddedSize(sizeof(header));
+
+  header.NodeIDs = { offset, writer.NodeIDs.size() };
+  offset += paddedSize(writer.NodeIDs.size() * sizeof(long long));
+
+  header.NodeLats = { offset, writer.NodeLats.size() };
+  offset += paddedSize(writer.NodeLats.size() * sizeof(NodeCoord));
+
+  header.NodeLons = { offset, writer.NodeLons.size() };
+  offset += paddedSize(writer.NodeLons.size() * sizeof(NodeCoord));
+
+  header.NodeEntrances = { offset, writer.NodeEntrances.size() };
+  offset += paddedSize(writer.NodeEntrances.size() * sizeof(uint64_t));
+
+  header.NodeIndices = { offset, writer.NodeIndexTable.size() };
+  offset += paddedSize(writer.NodeIndexTable.size() * sizeof(uint32_t));
+
+  header.Buildings = { offset, writer.BuildingTable.size() };
+  offset += paddedSize(writer.BuildingTable.size() * sizeof(SnapshotBuilding));
+
+  header.Amenities = { offset, writer.AmenityTable.size() };
+  offset += paddedSize(writer.AmenityTable.size() * sizeof(SnapshotAmenity));
+
+  header.Types = { offset, writer.TypeTable.size() };
+  offset += paddedSize(writer.TypeTable.size() * sizeof(SnapshotString));
+
+  header.GraphOffsets = { offset, writer.GraphOffsets.size() };
+  offset += paddedSize(writer.GraphOffsets.size() * sizeof(uint32_t));
+
+  header.GraphTargets = { offset, writer.GraphTargets.size() };
+  offset += paddedSize(writer.GraphTargets.size() * sizeof(uint32_t));
+
+  header.GraphWeights = { offset, writer.GraphWeights.size() };
+  offset += paddedSize(writer.GraphWeights.size() * sizeof(float));
+
+  header.HierarchyOffsets = { offset, writer.HierarchyOffsets.size() };
+  offset += paddedSize(writer.HierarchyOffsets.size() * sizeof(uint32_t));
+
+  header.HierarchyTargets = { offset, writer.HierarchyTargets.size() };
+  offset += paddedSize(writer.HierarchyTargets.size() * sizeof(uint32_t));
+
+  header.HierarchyWeights = { offset, writer.HierarchyWeights.size() };
+  offset += paddedSize(writer.HierarchyWeights.size() * sizeof(float));
+
+  header.Pool = { offset, writer.Pool.size() };
+
+  string tempFilename = snapFilename + ".tmp";
+
+  ofstream file(tempFilename, ios::binary | ios::trunc);
+
+  writeSection(file, &header, sizeof(header));
+  writeSection(file, writer.NodeIDs.data(), writer.NodeIDs.size() * sizeof(long long));
+  writeSection(file, writer.NodeLats.data(), writer.NodeLats.size() * sizeof(NodeCoord));
+  writeSection(file, writer.NodeLons.data(), writer.NodeLons.size() * sizeof(NodeCoord));
+  writeSection(file, writer.NodeEntrances.data(), writer.NodeEntrances.size() * sizeof(uint64_t));
+  writeSection(file, writer.NodeIndexTable.data(), writer.NodeIndexTable.size() * sizeof(uint32_t));
+  writeSection(file, writer.BuildingTable.data(), writer.BuildingTable.size() * sizeof(SnapshotBuilding));
+  writeSection(file, writer.AmenityTable.data(), writer.AmenityTable.size() * sizeof(SnapshotAmenity));
+  writeSection(file, writer.TypeTable.data(), writer.TypeTable.size() * sizeof(SnapshotString));
+  writeSection(file, writer.GraphOffsets.data(), writer.GraphOffsets.size() * sizeof(uint32_t));
+  writeSection(file, writer.GraphTargets.data(), writer.GraphTargets.size() * sizeof(uint32_t));
+  writeSection(file, writer.GraphWeights.data(), writer.GraphWeights.size() * sizeof(float));
+  writeSection(file, writer.HierarchyOffsets.data(), writer.HierarchyOffsets.size() * sizeof(uint32_t));
+  writeSection(file, writer.HierarchyTargets.data(), writer.HierarchyTargets.size() * sizeof(uint32_t));
+  writeSection(file, writer.HierarchyWeights.data(), writer.HierarchyWeights.size() * sizeof(float));
+  writeSection(file, writer.Pool.data(), writer.Pool.size());
+  file.close();
+
+  if (!file.good() || rename(tempFilename.c_str(), snapFilename.c_str()) != 0)
+  {
+    remove(tempFilename.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+
+//
+// Snapshot
+//
+Snapshot::Snapshot()
+  : NodeIndexTable(nullptr), NumNodeIndices(0),
+    BuildingTable(nullptr), NumBuildings(0), AmenityTable(nullptr), NumAmenities(0),
+    TypeTable(nullptr), NumTypes(0), Pool(nullptr), PoolSize(0)
+{
+}
+
+//
+// returns a pointer to the given section of the mapped file, or
+// nullptr if the section does not fit in the file after the
+// header. The count is checked by division, so a corrupt header
+// can't overflow the size:
+//
+static const char* sectionData(MappedFile& file, SnapshotSection section, size_t recordSize)
+{
+  if (section.Offset % 8 != 0 || section.Offset < sizeof(SnapshotHeader) ||
+    section.Offset > file.getSize())
+  {
+    return nullptr;
+  }
+
+  size_t available = file.getSize() - section.Offset;
+
+  if (section.Count > available / recordSize) {
+    return nullptr;
+  }
+
+  return file.getData() + section.Offset;
+}
+
+bool Snapshot::validString(SnapshotString s)
+{
+  return (uint64_t) s.Offset + s.Length <= this->PoolSize;
+}
+
+bool Snapshot::validNodeIndices(uint64_t offset, uint64_t count)
+{
+  return offset <= this->NumNodeIndices && count <= this->NumNodeIndices - offset;
+}
+
+//
+// a graph's edges are valid if there are none, or if each node's
+// edges are in order and in the targets, and lead to a node:
+//
+static bool validEdges(span<const uint32_t> offsets, span<const uint32_t> targets, span<const float> weights, uint64_t numNodes)
+{
+  if (offsets.empty() && targets.empty() && weights.empty()) {
+    return true;
+  }
+
+  if (offsets.size() != numNodes + 1 || offsets[0] != 0 ||
+    offsets[numNodes] != targets.size() || weights.size() != targets.size())
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < numNodes; i++)
+  {
+    if (offsets[i] > offsets[i + 1]) {
+      return false;
+    }
+  }
+
+  for (uint32_t target : targets)
+  {
+    if (target >= numNodes) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//
+// open
+//
+// Maps the given snapshot file and checks that it's intact and
+// up to date. The section sizes in the header are checked against
+// the size of the file before any table is used, and nothing is
+// allocated from them. Every string, node index range and node
+// index stored in the tables is bounds-checked here, once, so the
+// query code can use them without further checks.
+//
+bool Snapshot::open(string snapFilename, string osmFilename)
+{
+  if (!this->File.open(snapFilename, false /*random access*/)) {
+    return false;
+  }
+
+  SnapshotHeader header;
+  SnapshotHeader current;
+
+  if (this->File.getSize() < sizeof(header)) {
+    return false;
+  }
+
+  memcpy(&header, this->File.getData(), sizeof(header));
+
+  if (memcmp(header.Magic, SNAPSHOT_MAGIC, sizeof(header.Magic)) != 0 ||
+    header.Version != SNAPSHOT_VERSION ||
+    header.CoordSize != sizeof(NodeCoord))
+  {
+    return false;
+  }
+
+  //
+  // is the snapshot out of date?
+  //
+  if (!sourceFingerprint(osmFilename, current) ||
+    current.SourceSize != header.SourceSize ||
+    current.SourceMtime != header.SourceMtime ||
+    current.SourceHash != header.SourceHash)
+  {
+    return false;
+  }
+
+  const long long* nodeIDs = (const long long*) sectionData(this->File, header.NodeIDs, sizeof(long long));
+  const NodeCoord* nodeLats = (const NodeCoord*) sectionData(this->File, header.NodeLats, sizeof(NodeCoord));
+  const NodeCoord* nodeLons = (const NodeCoord*) sectionData(this->File, header.NodeLons, sizeof(NodeCoord));
+  const uint64_t* nodeEntrances = (const uint64_t*) sectionData(this->File, header.NodeEntrances, sizeof(uint64_t));
+  this->NodeIndexTable = (const uint32_t*) sectionData(this->File, header.NodeIndices, sizeof(uint32_t));
+  this->BuildingTable = (const SnapshotBuilding*) sectionData(this->File, header.Buildings, sizeof(SnapshotBuilding));
+  this->AmenityTable = (const SnapshotAmenity*) sectionData(this->File, header.Amenities, sizeof(SnapshotAmenity));
+  this->TypeTable = (const SnapshotString*) sectionData(this->File, header.Types, sizeof(SnapshotString));
+  const uint32_t* graphOffsets = (const uint32_t*) sectionData(this->File, header.GraphOffsets, sizeof(uint32_t));
+  const uint32_t* graphTargets = (const uint32_t*) sectionData(this->File, header.GraphTargets, sizeof(uint32_t));
+  const float* graphWeights = (const float*) sectionData(this->File, header.GraphWeights, sizeof(float));
+  const uint32_t* hierarchyOffsets = (const uint32_t*) sectionData(this->File, header.HierarchyOffsets, sizeof(uint32_t));
+  const uint32_t* hierarchyTargets = (const uint32_t*) sectionData(this->File, header.HierarchyTargets, sizeof(uint32_t));
+  const float* hierarchyWeights = (const float*) sectionData(this->File, header.HierarchyWeights, sizeof(float));
+  this->Pool = sectionData(this->File, header.Pool, 1);
+
+  if (nodeIDs == nullptr || nodeLats == nullptr || nodeLons == nullptr || nodeEntrances == nullptr ||
+    this->NodeIndexTable == nullptr ||
+    this->BuildingTable == nullptr || this->AmenityTable == nullptr ||
+    this->TypeTable == nullptr || this->Pool == nullptr ||
+    graphOffsets == nullptr || graphTargets == nullptr || graphWeights == nullptr ||
+    hierarchyOffsets == nullptr || hierarchyTargets == nullptr || hierarchyWeights == nullptr)
+  {
+    return false;
+  }
+
+  //
+  // the node arrays must all be for the same # of nodes:
+  //
+  uint64_t numNodes = header.NodeIDs.Count;
+
+  if (header.NodeLats.Count != numNodes || header.NodeLons.Count != numNodes ||
+    header.NodeEntrances.Count != (numNodes + 63) / 64)
+  {
+    return false;
+  }
+
+  this->NodeArrays.IDs = span<const long long>(nodeIDs, numNodes);
+  this->NodeArrays.Lats = span<const NodeCoord>(nodeLats, numNodes);
+  this->NodeArrays.Lons = span<const NodeCoord>(nodeLons, numNodes);
+  this->NodeArrays.Entrances = span<const uint64_t>(nodeEntrances, header.NodeEntrances.Count);
+
+  this->NumNodeIndices = header.NodeIndices.Count;
+  this->NumBuildings = header.Buildings.Count;
+  this->NumAmenities = header.Amenities.Count;
+  this->NumTypes = header.Types.Count;
+  this->PoolSize = header.Pool.Count;
+
+  for (const SnapshotBuilding& B : this->getBuildings())
+  {
+    if (!validString(B.Name) || !validString(B.StreetAddress) ||
+      !validNodeIndices(B.NodeIndicesOffset, B.NodeIndicesCount))
+    {
+      return false;
+    }
+  }
+
+  for (const SnapshotAmenity& A : this->getAmenities())
+  {
+    if (!validString(A.Name) || !validString(A.StreetAddress) ||
+      !validString(A.AmenityType) || !validNodeIndices(A.NodeIndicesOffset, A.NodeIndicesCount))
+    {
+      return false;
+    }
+  }
+
+  for (SnapshotString type : this->getTypes())
+  {
+    if (!validString(type)) {
+      return false;
+    }
+  }
+
+  //
+  // node indices are used without further checks, so they must
+  // all be in the node table:
+  //
+  for (size_t i = 0; i < this->NumNodeIndices; i++)
+  {
+    if (this->NodeIndexTable[i] >= numNodes) {
+      return false;
+    }
+  }
+
+  //
+  // likewise the edges of the walking graph and of the upward 
+  // graph of its hierarchy:
+  //
+  this->GraphOffsets = span<const uint32_t>(graphOffsets, header.GraphOffsets.Count);
+  this->GraphTargets = span<const uint32_t>(graphTargets, header.GraphTargets.Count);
+  this->GraphWeights = span<const float>(graphWeights, header.GraphWeights.Count);
+  this->HierarchyOffsets = span<const uint32_t>(hierarchyOffsets, header.HierarchyOffsets.Count);
+  this->HierarchyTargets = span<const uint32_t>(hierarchyTargets, header.HierarchyTargets.Count);
+  this->HierarchyWeights = span<const float>(hierarchyWeights, header.HierarchyWeights.Count);
+
+  if (!validEdges(this->GraphOffsets, this->GraphTargets, this->GraphWeights, numNodes) ||
+    !validEdges(this->HierarchyOffsets, this->HierarchyTargets, this->HierarchyWeights, numNodes))
+  {
+    return false;
+  }
+
+  return true;
+}
+
+//
+// the tables, used in place:
+//
+NodeTable Snapshot::getNodes()
+{ return this->NodeArrays; }
+
+span<const SnapshotBuilding> Snapshot::getBuildings()
+{ return span<const SnapshotBuilding>(this->BuildingTable, this->NumBuildings); }
+
+span<const SnapshotAmenity> Snapshot::getAmenities()
+{ return span<const SnapshotAmenity>(this->AmenityTable, this->NumAmenities); }
+
+span<const SnapshotString> Snapshot::getTypes()
+{ return span<const SnapshotString>(this->TypeTable, this->NumTypes); }
+
+span<const uint32_t> Snapshot::getGraphOffsets()
+{ return this->GraphOffsets; }
+
+span<const uint32_t> Snapshot::getGraphTargets()
+{ return this->GraphTargets; }
+
+span<const float> Snapshot::getGraphWeights()
+{ return this->GraphWeights; }
+
+span<const uint32_t> Snapshot::getHierarchyOffsets()
+{ return this->HierarchyOffsets; }
+
+span<const uint32_t> Snapshot::getHierarchyTargets()
+{ return this->HierarchyTargets; }
+
+span<const float> Snapshot::getHierarchyWeights()
+{ return this->HierarchyWeights; }
+
+//
+// resolves references into the pool / refs section:
+//
+string_view Snapshot::getString(SnapshotString s)
+{ return string_view(this->Pool + s.Offset, s.Length); }
+
+span<const uint32_t> Snapshot::getNodeIndices(uint64_t offset, uint64_t count)
+{ return span<const uint32_t>(this->NodeIndexTable + offset, count); }
+
+
+//
+// snapshotLoad
+//
+// Maps the given snapshot file, provided it matches the map file
+// it was made from, and sets the collections to use it in place.
+//
+bool snapshotLoad(string snapFilename, string osmFilename, Nodes& nodes, Buildings& buildings, Amenities& amenities, Graph& graph,
+  ContractionHierarchy& hierarchy)
+{
+  shared_ptr<Snapshot> snapshot = make_shared<Snapshot>();
+
+  if (!snapshot->open(snapFilename, osmFilename)) {
+    return false;
+  }
+
+  nodes.readSnapshot(snapshot);
+  buildings.readSnapshot(snapshot);
+  amenities.readSnapshot(snapshot);
+  graph.readSnapshot(snapshot);
+  hierarchy.readSnapshot(snapshot);
+
+  return true;
+}
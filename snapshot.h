@@ -0,0 +1,218 @@
+/*snapshot.h*/
+
+/**
+  * @brief binary snapshot of the parsed map.
+  *
+  * Parsing the XML map file dominates startup, so once the nodes,
+  * buildings, amenities and walking graph have been parsed (and
+  * the graph's contraction hierarchy built) they are saved to a
+  * binary snapshot next to the map file. Later runs memory-map the
+  * snapshot and query it in place, as long as the map file has not
+  * changed (same size, modification time and content hash). Nothing
+  * is deserialized: the tables are fixed-width records that are used
+  * directly from the mapped pages, so startup is near-instant and
+  * processes using the same map share one physical copy of it.
+  *
+  * Snapshot layout (version 6, native byte order, every section
+  * 8-byte aligned):
+  *
+  *   header     magic "NUOSMSNP", version, size of a NodeCoord, source
+  *              size / mtime / hash, and the (offset, count) of each 
+  *              of the sections below
+  *   node ids   node ids, sorted
+  *   node lats  NodeCoord latitude of each node
+  *   node lons  NodeCoord longitude of each node
+  *   entrances  bitset, 1 bit per node
+  *   indices    node table indices of the nodes of all buildings 
+  *              and amenities, back to back
+  *   buildings  SnapshotBuilding records, sorted by name
+  *   amenities  SnapshotAmenity records, sorted by name
+  *   types      SnapshotString per amenity type, sorted
+  *   offsets    walking graph: where the edges of each node start,
+  *              # of nodes + 1 (or none, if there is no graph)
+  *   targets    walking graph: the node each edge leads to
+  *   weights    walking graph: the length of each edge in miles
+  *   up offsets contraction hierarchy: the upward graph, in the same
+  *   up targets form as the walking graph
+  *   up weights
+  *   pool       the text of every string, back to back
+  *
+  * Strings are (offset, length) into the pool, and the nodes of a
+  * building or amenity are (offset, count) into the indices section.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <memory>
+#include <cstdint>
+
+#include "mappedfile.h"
+#include "node.h"
+
+using namespace std;
+
+class Nodes;
+class Buildings;
+class Amenities;
+class Graph;
+class ContractionHierarchy;
+
+
+//
+// fixed-width records stored in the snapshot:
+//
+struct SnapshotString
+{
+  uint32_t Offset;  // into the pool
+  uint32_t Length;
+};
+
+struct SnapshotBuilding
+{
+  int64_t        ID;
+  SnapshotString Name;
+  SnapshotString StreetAddress;
+  uint64_t       NodeIndicesOffset;  // into the indices section
+  uint64_t       NodeIndicesCount;
+};
+
+struct SnapshotAmenity
+{
+  int64_t        ID;
+  SnapshotString Name;
+  SnapshotString StreetAddress;
+  SnapshotString AmenityType;
+  uint32_t       Padding;
+  uint64_t       NodeIndicesOffset;  // into the indices section
+  uint64_t       NodeIndicesCount;
+};
+
+
+/**
+  * @brief collects the tables of a snapshot as it's being written.
+  */
+class SnapshotWriter
+{
+public:
+  vector<long long>        NodeIDs;
+  vector<NodeCoord>        NodeLats;
+  vector<NodeCoord>        NodeLons;
+  vector<uint64_t>         NodeEntrances;
+  vector<uint32_t>         NodeIndexTable;
+  vector<SnapshotBuilding> BuildingTable;
+  vector<SnapshotAmenity>  AmenityTable;
+  vector<SnapshotString>   TypeTable;
+  vector<uint32_t>         GraphOffsets;
+  vector<uint32_t>         GraphTargets;
+  vector<float>            GraphWeights;
+  vector<uint32_t>         HierarchyOffsets;
+  vector<uint32_t>         HierarchyTargets;
+  vector<float>            HierarchyWeights;
+  string                   Pool;
+
+  // copies the string into the pool, returning its reference
+  SnapshotString addString(string_view s);
+
+  // copies the node indices into the indices section, returning
+  // the offset
+  uint64_t addNodeIndices(span<const uint32_t> indices);
+};
+
+
+/**
+  * @brief a snapshot file, memory-mapped and validated.
+  *
+  * The collections that are loaded from a snapshot keep a shared 
+  * pointer to it, so the mapping stays alive as long as any of 
+  * them is using it.
+  */
+class Snapshot
+{
+private:
+  MappedFile File;
+
+  NodeTable               NodeArrays;
+  const uint32_t*         NodeIndexTable;
+  size_t                  NumNodeIndices;
+  const SnapshotBuilding* BuildingTable;
+  size_t                  NumBuildings;
+  const SnapshotAmenity*  AmenityTable;
+  size_t                  NumAmenities;
+  const SnapshotString*   TypeTable;
+  size_t                  NumTypes;
+  span<const uint32_t>    GraphOffsets;
+  span<const uint32_t>    GraphTargets;
+  span<const float>       GraphWeights;
+  span<const uint32_t>    HierarchyOffsets;
+  span<const uint32_t>    HierarchyTargets;
+  span<const float>       HierarchyWeights;
+  const char*             Pool;
+  size_t                  PoolSize;
+
+  bool validString(SnapshotString s);
+  bool validNodeIndices(uint64_t offset, uint64_t count);
+
+public:
+  Snapshot();
+
+/**
+  * @brief maps and validates the given snapshot file.
+  *
+  * @param snapFilename The snapshot file to map.
+  * @param osmFilename The map file the snapshot must match.
+  * @return true if successful, false if the snapshot is missing,
+  *   corrupt, from another version, or out of date with respect to
+  *   the map file.
+  */
+  bool open(string snapFilename, string osmFilename);
+
+  // the tables, used in place:
+  NodeTable                    getNodes();
+  span<const SnapshotBuilding> getBuildings();
+  span<const SnapshotAmenity>  getAmenities();
+  span<const SnapshotString>   getTypes();
+  span<const uint32_t>         getGraphOffsets();
+  span<const uint32_t>         getGraphTargets();
+  span<const float>            getGraphWeights();
+  span<const uint32_t>         getHierarchyOffsets();
+  span<const uint32_t>         getHierarchyTargets();
+  span<const float>            getHierarchyWeights();
+
+  // resolves references into the pool / indices section:
+  string_view getString(SnapshotString s);
+  span<const uint32_t> getNodeIndices(uint64_t offset, uint64_t count);
+};
+
+
+/**
+  * @brief saves the parsed map to a snapshot file.
+  *
+  * @param snapFilename The snapshot file to write.
+  * @param osmFilename The map file the data was parsed from.
+  * @return true if successful, false if the file could not be written.
+  */
+bool snapshotSave(string snapFilename, string osmFilename, Nodes& nodes, Buildings& buildings, Amenities& amenities, Graph& graph,
+  ContractionHierarchy& hierarchy);
+
+/**
+  * @brief loads the parsed map from a snapshot file.
+  *
+  * The snapshot is memory-mapped and the collections are set to
+  * use it in place. They are only replaced if the snapshot opens
+  * successfully.
+  *
+  * @param snapFilename The snapshot file to map.
+  * @param osmFilename The map file the snapshot must match.
+  * @return true if successful, false if the snapshot is missing,
+  *   corrupt, from another version, or out of date with respect to
+  *   the map file.
+  */
+bool snapshotLoad(string snapFilename, string osmFilename, Nodes& nodes, Buildings& buildings, Amenities& amenities, Graph& graph,
+  ContractionHierarchy& hierarchy);
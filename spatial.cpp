@@ -0,0 +1,323 @@
+/*spatial.cpp*/
+
+//
+// A static k-d tree over points on the map, for nearest-neighbour
+// and radius queries.
+//
+// Jay Rao
+// Northwestern University
+// CS 211
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+#include "spatial.h"
+#include "dist.h"
+
+using namespace std;
+
+
+//
+// converts (lat, lon) in degrees to a point on the unit sphere:
+//
+static void toUnitVector(double lat, double lon, double v[3])
+{
+  double phi = lat * M_PI / 180.0;
+  double lambda = lon * M_PI / 180.0;
+
+  v[0] = cos(phi) * cos(lambda);
+  v[1] = cos(phi) * sin(lambda);
+  v[2] = sin(phi);
+}
+
+//
+// squared chord length between two unit vectors:
+//
+static double chord2(const double a[3], double x, double y, double z)
+{
+  double dx = a[0] - x;
+  double dy = a[1] - y;
+  double dz = a[2] - z;
+
+  return dx * dx + dy * dy + dz * dz;
+}
+
+//
+// squared chord length spanning the given distance along the
+// earth's surface; same earth radius as distBetween2Points:
+//
+static double milesToChord2(double miles)
+{
+  const double R = 6371;  // km
+
+  double angle = (miles / 0.6213711922) / R;
+
+  if (angle >= M_PI) {
+    return 4.0;  // the whole sphere
+  }
+
+  double chord = 2 * sin(angle / 2);
+
+  return chord * chord;
+}
+
+
+//
+// constructor
+//
+SpatialIndex::SpatialIndex()
+{
+}
+
+
+//
+// add
+//
+void SpatialIndex::add(int item, double lat, double lon)
+{
+  if (std::isnan(lat) || std::isnan(lon)) {
+    return;
+  }
+
+  Point p;
+  double v[3];
+
+  toUnitVector(lat, lon, v);
+
+  p.X = v[0];
+  p.Y = v[1];
+  p.Z = v[2];
+  p.Lat = lat;
+  p.Lon = lon;
+  p.Item = item;
+
+  this->Points.push_back(p);
+}
+
+
+//
+// build
+//
+void SpatialIndex::build()
+{
+  this->Axes.assign(this->Points.size(), 0);
+
+  this->buildRange(0, this->Points.size());
+}
+
+//
+// splits [lo, hi) at the median along the axis with the largest
+// spread, then splits each side the same way:
+//
+void SpatialIndex::buildRange(size_t lo, size_t hi)
+{
+  if (hi - lo <= 1) {
+    return;
+  }
+
+  double mins[3] = { 2, 2, 2 };
+  double maxs[3] = { -2, -2, -2 };
+
+  for (size_t i = lo; i < hi; i++) {
+    const double v[3] = { this->Points[i].X, this->Points[i].Y, this->Points[i].Z };
+
+    for (int a = 0; a < 3; a++) {
+      mins[a] = min(mins[a], v[a]);
+      maxs[a] = max(maxs[a], v[a]);
+    }
+  }
+
+  uint8_t axis = 0;
+
+  for (uint8_t a = 1; a < 3; a++) {
+    if (maxs[a] - mins[a] > maxs[axis] - mins[axis]) {
+      axis = a;
+    }
+  }
+
+  size_t mid = (lo + hi) / 2;
+
+  nth_element(this->Points.begin() + lo, this->Points.begin() + mid, this->Points.begin() + hi,
+    [axis](const Point& p1, const Point& p2) -> bool
+    {
+      const double v1[3] = { p1.X, p1.Y, p1.Z };
+      const double v2[3] = { p2.X, p2.Y, p2.Z };
+
+      return v1[axis] < v2[axis];
+    }
+  );
+
+  this->Axes[mid] = axis;
+
+  this->buildRange(lo, mid);
+  this->buildRange(mid + 1, hi);
+}
+
+
+//
+// size
+//
+size_t SpatialIndex::size() const
+{
+  return this->Points.size();
+}
+
+
+//
+// visits every point in [lo, hi) whose squared chord distance from
+// q is at most bound2, nearer side first; visit may lower bound2
+// as the search goes, which prunes the rest of the search:
+//
+template <typename VISIT>
+void SpatialIndex::search(size_t lo, size_t hi, const double q[3], double& bound2, VISIT& visit) const
+{
+  if (lo >= hi) {
+    return;
+  }
+
+  size_t mid = (lo + hi) / 2;
+  const Point& p = this->Points[mid];
+
+  double d2 = chord2(q, p.X, p.Y, p.Z);
+
+  if (d2 <= bound2) {
+    visit(mid, d2);
+  }
+
+  const double v[3] = { p.X, p.Y, p.Z };
+  double diff = q[this->Axes[mid]] - v[this->Axes[mid]];
+
+  if (diff < 0) {
+    this->search(lo, mid, q, bound2, visit);
+
+    if (diff * diff <= bound2) {
+      this->search(mid + 1, hi, q, bound2, visit);
+    }
+  }
+  else {
+    this->search(mid + 1, hi, q, bound2, visit);
+
+    if (diff * diff <= bound2) {
+      this->search(lo, mid, q, bound2, visit);
+    }
+  }
+}
+
+
+//
+// the reported distance is the haversine distance, so it's the
+// same as the rest of the program computes:
+//
+SpatialIndex::Neighbor SpatialIndex::toNeighbor(const Point& p, double lat, double lon) const
+{
+  Neighbor n;
+
+  n.Item = p.Item;
+  n.Distance = distBetween2Points(lat, lon, p.Lat, p.Lon);
+
+  return n;
+}
+
+//
+// nearest first, ties by item:
+//
+static void sortNeighbors(vector<SpatialIndex::Neighbor>& neighbors)
+{
+  sort(neighbors.begin(), neighbors.end(),
+    [](const SpatialIndex::Neighbor& n1, const SpatialIndex::Neighbor& n2) -> bool
+    {
+      if (n1.Distance != n2.Distance) {
+        return n1.Distance < n2.Distance;
+      }
+      return n1.Item < n2.Item;
+    }
+  );
+}
+
+
+//
+// nearest
+//
+vector<SpatialIndex::Neighbor> SpatialIndex::nearest(double lat, double lon, size_t k) const
+{
+  vector<Neighbor> result;
+
+  if (k == 0 || this->Points.empty()) {
+    return result;
+  }
+
+  double q[3];
+
+  toUnitVector(lat, lon, q);
+
+  //
+  // the k nearest so far, farthest on top; once there are k, the
+  // farthest of them bounds the search:
+  //
+  priority_queue<pair<double, size_t>> best;
+  double bound2 = numeric_limits<double>::infinity();
+
+  auto visit = [&](size_t i, double d2)
+  {
+    best.push(make_pair(d2, i));
+
+    if (best.size() > k) {
+      best.pop();
+    }
+    if (best.size() == k) {
+      bound2 = best.top().first;
+    }
+  };
+
+  this->search(0, this->Points.size(), q, bound2, visit);
+
+  while (!best.empty()) {
+    result.push_back(this->toNeighbor(this->Points[best.top().second], lat, lon));
+    best.pop();
+  }
+
+  sortNeighbors(result);
+
+  return result;
+}
+
+
+//
+// withinRadius
+//
+vector<SpatialIndex::Neighbor> SpatialIndex::withinRadius(double lat, double lon, double miles) const
+{
+  vector<Neighbor> result;
+
+  if (miles < 0 || this->Points.empty()) {
+    return result;
+  }
+
+  double q[3];
+
+  toUnitVector(lat, lon, q);
+
+  //
+  // search a hair wider than the radius to allow for roundoff,
+  // then keep exactly the points whose distance is within it:
+  //
+  double bound2 = milesToChord2(miles) * (1 + 1e-9) + 1e-15;
+
+  auto visit = [&](size_t i, double d2)
+  {
+    Neighbor n = this->toNeighbor(this->Points[i], lat, lon);
+
+    if (n.Distance <= miles) {
+      result.push_back(n);
+    }
+  };
+
+  this->search(0, this->Points.size(), q, bound2, visit);
+
+  sortNeighbors(result);
+
+  return result;
+}
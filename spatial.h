@@ -0,0 +1,120 @@
+/*spatial.h*/
+
+/**
+  * @brief spatial index over points on the map.
+  *
+  * A static k-d tree over (latitude, longitude) points, answering
+  * k-nearest-neighbour and radius queries in miles.
+  *
+  * @note Written by Jay Rao
+  * @note Northwestern University
+  */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+
+/**
+  * @brief spatial index over points on the map.
+  *
+  * Each point carries an item number, e.g. its position in the
+  * Amenities collection. Points are stored as 3D unit vectors, so
+  * the straight-line (chord) distance between two points orders
+  * them exactly as the great-circle distance does; the tree is
+  * searched by chord distance, and the distances it reports are
+  * computed with distBetween2Points, so they match the rest of the
+  * program. The index is built once and is read-only after that.
+  */
+class SpatialIndex
+{
+public:
+  //
+  // a point found by a query, and its distance from the query
+  // point in miles:
+  //
+  struct Neighbor
+  {
+    int    Item;
+    double Distance;
+  };
+
+/**
+  * @brief default constructor, creates an empty index.
+  */
+  SpatialIndex();
+
+/**
+  * @brief adds a point; call build( ) once all points are added.
+  *
+  * Points whose position is not a number (e.g. the location of
+  * an amenity with no nodes in the map) are ignored.
+  *
+  * @param item The item number reported by the queries.
+  * @param lat Latitude of the point.
+  * @param lon Longitude of the point.
+  * @return nothing.
+  */
+  void add(int item, double lat, double lon);
+
+/**
+  * @brief builds the tree over the points added so far.
+  *
+  * @return nothing.
+  */
+  void build();
+
+/**
+  * @brief # of points in the index.
+  *
+  * @return the # of points.
+  */
+  size_t size() const;
+
+/**
+  * @brief finds the k points nearest to (lat, lon).
+  *
+  * @param lat Latitude of the query point.
+  * @param lon Longitude of the query point.
+  * @param k The # of points wanted.
+  * @return up to k points, nearest first.
+  */
+  vector<Neighbor> nearest(double lat, double lon, size_t k) const;
+
+/**
+  * @brief finds all the points within the given distance of (lat, lon).
+  *
+  * @param lat Latitude of the query point.
+  * @param lon Longitude of the query point.
+  * @param miles The search radius in miles.
+  * @return the points within the radius, nearest first.
+  */
+  vector<Neighbor> withinRadius(double lat, double lon, double miles) const;
+
+private:
+  struct Point
+  {
+    double X, Y, Z;   // unit vector
+    double Lat, Lon;
+    int    Item;
+  };
+
+  //
+  // the tree is implicit: the points in [lo, hi) are split at
+  // mid = (lo + hi) / 2, with Axes[mid] the split axis, the points
+  // before mid on the low side and the points after on the high
+  // side:
+  //
+  vector<Point>   Points;
+  vector<uint8_t> Axes;
+
+  void buildRange(size_t lo, size_t hi);
+
+  template <typename VISIT>
+  void search(size_t lo, size_t hi, const double q[3], double& bound2, VISIT& visit) const;
+
+  Neighbor toNeighbor(const Point& p, double lat, double lon) const;
+};